@@ -3,871 +3,5429 @@
 
 #include <functional>
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "ADS_thread_pool.h"
+
+#if defined(ADS_SET_WITH_LZ4)
+#include <lz4.h>
+#endif
+
+#if !defined(ADS_SET_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define ADS_SET_SIMD_AVX2
+#elif !defined(ADS_SET_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define ADS_SET_SIMD_SSE2
+#elif !defined(ADS_SET_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ADS_SET_SIMD_NEON
+#endif
 
 /**
- * Set implemented with Linear hashing scheme.
- *
- * @tparam Key key type
- * @tparam N size of the buckets (b in lectures)
+ * Amount of tags in a group, tags are padded to whole groups. It doesn't depend on the instruction
+ * set, so translation units built with different flags share one layout of the buckets.
  */
-template<typename Key, size_t N = 5>
-class ADS_set {
-public:
-    class Bucket;
+constexpr size_t ADS_set_tag_group_size {16};
 
-    class Iterator;
+/**
+ * Growth policies for the overflow pages of a bucket.
+ */
+enum class ADS_set_overflow {
+    /** Every overflow page holds N values */
+    paged,
 
-    using value_type = Key;
-    using key_type = Key;
-    using reference = value_type&;
-    using const_reference = const value_type&;
-    using size_type = size_t;
-    using difference_type = std::ptrdiff_t;
-    using const_iterator = Iterator;
-    using iterator = const_iterator;
-    using key_equal = std::equal_to<key_type>;
-    using hasher = std::hash<key_type>;
-private:
-    /** Split round (d in lectures) */
-    size_type split_round {0};
+    /** Every overflow page holds twice as many values as the previous one */
+    geometric
+};
 
-    /** Index of next bucket that should be split (nextToSplit in lectures) */
-    size_type table_split_index {0};
+/**
+ * Fingerprints stored alongside each value of a bucket.
+ */
+enum class ADS_set_fingerprint {
+    /** No fingerprints are stored */
+    none,
 
-    /** Number of buckets */
-    size_type table_size {0};
+    /** The hash's most significant byte is stored and compared before the keys */
+    tag,
 
-    /** Number of total values stored in buckets */
-    size_type table_items_size {0};
+    /** The full hash is stored, so splits don't need to hash the keys again */
+    hash
+};
 
-    /** Table of buckets */
-    Bucket* table {nullptr};
+/**
+ * Finalizers applied to the hashes of the hash function object.
+ */
+enum class ADS_set_mixer {
+    /** Hashes are used as they are */
+    none,
 
-    /** Hash instance */
-    const hasher hash {};
+    /** Hashes are mixed by the finalizer of MurmurHash3, so every bit depends on all bits of the hash */
+    fmix
+};
 
-    /** Hash function for current split round */
-    size_type h(const key_type& key) const {
-        return hash(key) % (1 << split_round);
-    }
+/**
+ * Compile-time options of ADS_set. Specialize it for a key type, or derive from it and
+ * redeclare single options to pass as Traits.
+ *
+ * @tparam Key key type
+ */
+template<typename Key>
+struct ADS_set_traits {
+    /** Growth policy of overflow pages */
+    static constexpr ADS_set_overflow overflow {ADS_set_overflow::paged};
 
-    /** Hash function for next split round */
-    size_type g(const key_type& key) const {
-        return hash(key) % (1 << (split_round + 1));
-    }
+    /** Fingerprints stored per value, comparing arithmetic keys is as cheap as comparing tags */
+    static constexpr ADS_set_fingerprint fingerprint {
+            std::is_arithmetic<Key>::value ? ADS_set_fingerprint::none : ADS_set_fingerprint::tag};
 
-    /**
-     * Get the bucket where the given key's value should be at.
-     *
-     * @param key the key to probe for
-     * @return reference to bucket
-     */
-    Bucket& bucket_at(const key_type& key) const;
+    /** Finalizer of the hashes, mixing helps hashes like the identity hash of integers with strided keys */
+    static constexpr ADS_set_mixer mixer {ADS_set_mixer::none};
 
-    /**
-     * Allocates the given amount of buckets for the hash table.
-     * This method will silently ignore smaller new table sizes.
-     *
-     * @param new_table_size
-     */
-    void reserve(size_type new_table_size);
+    /** Whether splits, overflow pages and lookups are counted for ADS_set::stats() */
+    static constexpr bool stats {false};
 
     /**
-     * Split the next bucket that should be split.
+     * Amount of values a split examines per insert or erase, splits are done at once if 0.
+     * Otherwise the values of a split bucket move over many operations and calls of
+     * ADS_set::maintenance(), which bounds the work of single inserts. Lookups missing the
+     * partner bucket of a split in progress check the split bucket too. The segment of the next
+     * doubling is constructed a few buckets per split of the round before it.
      */
-    void split();
+    static constexpr size_t split_budget {0};
 
-public:
     /**
-     * Creates an empty set.
+     * Whether every bucket keeps a 64-bit signature of its values' hashes, which answers most
+     * lookups of missing keys without touching the bucket. It costs 8 bytes per bucket and pays
+     * off if most lookups miss.
      */
-    ADS_set();
+    static constexpr bool prefilter {false};
+};
 
-    /**
-     * Delete the set.
-     */
-    ~ADS_set();
+/**
+ * Default bucket size of ADS_set for a key type: the largest N whose bucket, with its inline values,
+ * fingerprints, size and overflow pointer, fits one cache line. Keys too large for two values per
+ * line get as many values as fit two lines, but at least one. The fingerprints are those of
+ * ADS_set_traits<Key>, since the default of N can't depend on the Traits argument.
+ *
+ * @tparam Key key type
+ */
+template<typename Key>
+struct ADS_set_default_bucket_size {
+    /** Size of a cache line in bytes */
+    static constexpr size_t cache_line_size {64};
 
     /**
-     * Creates a set with a given range of items.
-     *
-     * @tparam InputIt type of input iterator
-     * @param first first item in range
-     * @param last last item in range
+     * Round a size up to a multiple of an alignment.
      */
-    template<typename InputIt>
-    ADS_set(InputIt first, InputIt last);
+    static constexpr size_t round_up(size_t size, size_t alignment) { return (size + alignment - 1) / alignment * alignment; }
 
     /**
-     * Creates an ADS_set with a given list of keys.
+     * Get the size of a bucket holding the given amount of inline values.
      *
-     * @param ilist list of keys to initialize with
+     * @param count amount of values
+     * @return size in bytes
      */
-    ADS_set(std::initializer_list<key_type> ilist);
+    static constexpr size_t bucket_bytes(size_t count) {
+        constexpr ADS_set_fingerprint fingerprint {ADS_set_traits<Key>::fingerprint};
+        constexpr size_t alignment {alignof(Key) > alignof(size_t) ? alignof(Key) : alignof(size_t)};
 
-    /**
-     * Creates a copy of a given set.
-     *
-     * @param other other set to copy from
-     */
-    ADS_set(const ADS_set& other);
+        size_t bytes {0};
 
-    /**
-     * Creates a set by moving values from other set.
-     *
-     * @param other other set to move from
-     */
-    ADS_set(ADS_set&& other) noexcept;
+        if (fingerprint == ADS_set_fingerprint::tag) bytes = round_up(count, ADS_set_tag_group_size);
+        if (fingerprint == ADS_set_fingerprint::hash) bytes = count * sizeof(size_t);
 
-    /**
-     * Copies the values of other set to this set by assignment operator.
-     *
-     * @param other other set to copy from
-     * @return reference to this set
-     */
-    ADS_set& operator=(ADS_set other);
+        // Size of values, the values and the overflow pointer follow the fingerprints
+        bytes = round_up(round_up(bytes, alignof(size_t)) + sizeof(size_t), alignof(Key)) + count * sizeof(Key);
+        bytes = round_up(bytes, alignof(void*)) + sizeof(void*);
+
+        return round_up(bytes, alignment);
+    }
 
     /**
-     * Copies the list of keys to this set by assignment operator.
+     * Get the largest amount of values whose bucket fits the given amount of cache lines.
      *
-     * @param ilist list of keys to copy from
-     * @return reference to this set
+     * @param lines amount of cache lines
+     * @return amount of values; if not even one fits 0
      */
-    ADS_set& operator=(std::initializer_list<key_type> ilist);
+    static constexpr size_t fitting(size_t lines) {
+        size_t count {0};
+
+        while (bucket_bytes(count + 1) <= lines * cache_line_size) ++count;
+
+        return count;
+    }
+
+    /** The default bucket size */
+    static constexpr size_t value {fitting(1) >= 2 ? fitting(1) : fitting(2) >= 1 ? fitting(2) : 1};
+};
+
+/**
+ * Fingerprints for a fixed amount of values, which is empty if fingerprints are disabled.
+ *
+ * @tparam Fingerprint type of fingerprint
+ * @tparam Count amount of values
+ * @tparam Enabled whether fingerprints are stored
+ */
+template<typename Fingerprint, size_t Count, bool Enabled>
+class ADS_set_fingerprints {
+    /** Fingerprint per value */
+    Fingerprint fingerprints[Count] {};
 
+public:
     /**
-     * Insert a given key.
+     * Get the fingerprints.
      *
-     * @param key the key to insert
-     * @return iterator for value and boolean whether it was newly added
+     * @return pointer to the first fingerprint
      */
-    std::pair<iterator, bool> insert(const key_type& key);
+    const Fingerprint* data() const { return fingerprints; }
 
     /**
-     * Insert a range of given keys.
+     * Get the fingerprint at a given index.
      *
-     * @tparam InputIt type of input iterator
-     * @param first first item in range
-     * @param last last item in range
+     * @param index index of value
+     * @return fingerprint of value
      */
-    template<typename InputIt>
-    void insert(InputIt first, InputIt last);
+    Fingerprint get(size_t index) const { return fingerprints[index]; }
 
     /**
-     * Insert a given list of keys.
+     * Set the fingerprint at a given index.
      *
-     * @param ilist list of keys to insert
+     * @param index index of value
+     * @param fingerprint fingerprint of value
      */
-    void insert(std::initializer_list<key_type> ilist);
+    void set(size_t index, Fingerprint fingerprint) { fingerprints[index] = fingerprint; }
+};
 
-    /**
-     * Clear all values of the set.
-     */
-    void clear();
+template<typename Fingerprint, size_t Count>
+class ADS_set_fingerprints<Fingerprint, Count, false> {
+public:
+    const Fingerprint* data() const { return nullptr; }
 
-    /**
-     * Removes the given key from the hash table.
-     *
-     * @param key the key to remove
-     * @return the amount of removed elements
-     */
-    size_type erase(const key_type& key);
+    Fingerprint get(size_t) const { return {}; }
 
-    /**
-     * Count how many times a key exists in the set (0 or 1).
-     *
-     * @param key the key to count for
-     * @return how many times the key exists (0 or 1)
-     */
-    size_type count(const key_type& key) const;
+    void set(size_t, Fingerprint) {}
+};
+
+/**
+ * Events counted by ADS_set_counters.
+ */
+enum class ADS_set_event {
+    /** A bucket was split */
+    split,
+
+    /** A segment of buckets was allocated, doubling the table */
+    doubling,
+
+    /** Bytes of values moved to other buckets by splits and merges */
+    bytes_moved,
+
+    /** An overflow page was added to a bucket */
+    expansion,
+
+    /** A lookup found its key */
+    hit,
+
+    /** A lookup didn't find its key */
+    miss,
+
+    /** Values examined by lookups that found their key */
+    hit_probe,
+
+    /** Values examined by lookups that didn't find their key */
+    miss_probe,
+
+    /** A lookup was answered by the prefilter without touching its bucket */
+    filtered_miss,
+
+    /** Amount of events */
+    size
+};
+
+/**
+ * Counters of events, which are empty and ignore all events if counting is disabled. Events are
+ * counted with relaxed atomics, so concurrent lookups can count them. Sets derive from it, so
+ * disabled counters take no space.
+ *
+ * @tparam Enabled whether events are counted
+ */
+template<bool Enabled>
+class ADS_set_counters {
+    /** Counter per event */
+    mutable std::atomic<size_t> values[static_cast<size_t>(ADS_set_event::size)] {};
+
+public:
+    ADS_set_counters() = default;
 
     /**
-     * Finds the given key's value in the hash table.
-     *
-     * @param key the key to find
-     * @return iterator of found value; if nothing was found the end iterator
+     * Creates counters starting from zero, counts aren't copied along with the values.
      */
-    iterator find(const key_type& key) const;
+    ADS_set_counters(const ADS_set_counters&) : ADS_set_counters {} {}
+
+    ADS_set_counters& operator=(const ADS_set_counters&) = delete;
 
     /**
-     * Swap this set with the given other set.
+     * Count an event.
      *
-     * @param other the set to swap with
+     * @param event the event
+     * @param amount how many times it happened
      */
-    void swap(ADS_set& other);
+    void add(ADS_set_event event, size_t amount = 1) const {
+        values[static_cast<size_t>(event)].fetch_add(amount, std::memory_order_relaxed);
+    }
 
     /**
-     * Get the iterator to the first item in the hash table.
+     * Get how many times an event happened.
      *
-     * @return iterator to first item
+     * @param event the event
+     * @return count of the event
      */
-    const_iterator begin() const;
+    size_t get(ADS_set_event event) const {
+        return values[static_cast<size_t>(event)].load(std::memory_order_relaxed);
+    }
 
     /**
-     * Get the Iterator after the last item in the hash table.
+     * Add the counts of other counters.
      *
-     * @return Iterator after the last item
+     * @param other the counters to add
      */
-    const_iterator end() const;
+    void add(const ADS_set_counters& other) const {
+        for (size_t i {0}; i < static_cast<size_t>(ADS_set_event::size); ++i) {
+            add(static_cast<ADS_set_event>(i), other.get(static_cast<ADS_set_event>(i)));
+        }
+    }
 
     /**
-     * Get the total amount of stored values.
+     * Swap the counts with other counters.
      *
-     * @return total amount of stored values
+     * @param other the counters to swap with
      */
-    [[nodiscard]] size_type size() const { return table_items_size; };
+    void swap(ADS_set_counters& other) {
+        for (size_t i {0}; i < static_cast<size_t>(ADS_set_event::size); ++i) {
+            values[i].store(other.values[i].exchange(values[i].load(std::memory_order_relaxed),
+                                                     std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
 
     /**
-     * Get whether the set is empty.
+     * Get the counters of a deriving class.
      *
-     * @return if set is empty
+     * @return reference to the counters
      */
-    [[nodiscard]] bool empty() const { return table_items_size == 0; };
+    const ADS_set_counters& counters() const { return *this; }
 
     /**
-     * Dump the set's content to a given stream.
+     * Get the counters of a deriving class.
      *
-     * @param o the stream to dump to
+     * @return reference to the counters
      */
-    void dump(std::ostream& o = std::cerr) const;
+    ADS_set_counters& counters() { return *this; }
+};
 
-    friend bool operator==(const ADS_set& lhs, const ADS_set& rhs) {
-        if (lhs.table_items_size != rhs.table_items_size) return false;
+template<>
+class ADS_set_counters<false> {
+public:
+    void add(ADS_set_event, size_t = 1) const {}
 
-        for (const auto& item: lhs) {
-            if (!rhs.count(item)) return false;
-        }
+    size_t get(ADS_set_event) const { return 0; }
 
-        return true;
-    }
+    void add(const ADS_set_counters&) const {}
 
-    friend bool operator!=(const ADS_set& lhs, const ADS_set& rhs) {
-        return !(lhs == rhs);
-    }
+    void swap(ADS_set_counters&) {}
+
+    const ADS_set_counters& counters() const { return *this; }
+
+    ADS_set_counters& counters() { return *this; }
 };
 
-template<typename Key, size_t N>
-class ADS_set<Key, N>::Bucket {
-    /** Amount of stored values */
-    size_type values_size {0};
+/**
+ * Progress of the split in progress of sets that split incrementally, which is empty for sets
+ * splitting at once. Sets derive from it, so unused progress takes no space.
+ *
+ * @tparam Enabled whether splits are incremental
+ */
+template<bool Enabled>
+struct ADS_set_split_progress {
+    /** Whether a split is in progress */
+    bool active {false};
 
-    /** Capacity of bucket */
-    size_type values_capacity {0};
+    /** Index of the bucket being split */
+    size_t from {0};
 
-    /** Array of values */
-    value_type* values {nullptr};
+    /** Index of the partner bucket receiving the moved values */
+    size_t to {0};
 
-    /**
-     * Expand the capacity of Bucket by N values.
-     */
-    void expand();
+    /** Index of the first value of the split bucket not examined yet */
+    size_t cursor {0};
 
-public:
-    /**
-     * Creates an empty bucket.
-     */
-    Bucket();
+    /** Amount of splits waiting for the split in progress */
+    size_t queued {0};
+
+    /** Signature of the values that stay in the split bucket, if the set has a prefilter */
+    size_t kept_signature {0};
 
     /**
-     * Delete this bucket.
+     * Segment of the next doubling, whose buckets are constructed a few per split of the
+     * current round, so no single split constructs a whole segment. It isn't part of the table
+     * until the doubling.
      */
-    ~Bucket();
+    struct Prepared {
+        /** Memory of the segment's buckets; nullptr if no segment is prepared */
+        unsigned char* buckets {nullptr};
+
+        /** Occupancy bitmap and signatures of the segment */
+        size_t* bookkeeping {nullptr};
+
+        /** Amount of constructed buckets, whose bookkeeping words are zeroed */
+        size_t count {0};
+    } prepared;
 
     /**
-     * Creates a copy of a given bucket.
+     * Get the progress of a deriving class.
      *
-     * @param other other bucket to copy from
+     * @return reference to the progress
      */
-    Bucket(const Bucket& other);
+    const ADS_set_split_progress& split_progress() const { return *this; }
 
     /**
-     * Creates a bucket by moving values from other bucket.
+     * Get the progress of a deriving class.
      *
-     * @param other other bucket to move from
+     * @return reference to the progress
      */
-    Bucket(Bucket&& other) noexcept;
+    ADS_set_split_progress& split_progress() { return *this; }
+};
+
+template<>
+struct ADS_set_split_progress<false> {
+    const ADS_set_split_progress& split_progress() const { return *this; }
+
+    ADS_set_split_progress& split_progress() { return *this; }
+};
+
+/**
+ * Holder of an allocator, which takes no space if the allocator is empty. The pools of sets
+ * derive from it.
+ *
+ * @tparam Allocator allocator type
+ */
+template<typename Allocator, bool Empty = std::is_empty_v<Allocator> && !std::is_final_v<Allocator>>
+class ADS_set_allocator_holder {
+    /** The held allocator */
+    Allocator held;
 
+public:
     /**
-     * Copies the values of the other bucket to this bucket by assignment operator.
+     * Creates a holder of a copy of the given allocator.
      *
-     * @param other other bucket to copy from
-     * @return reference to this bucket
+     * @param allocator the allocator to hold
      */
-    Bucket& operator=(Bucket other);
+    explicit ADS_set_allocator_holder(const Allocator& allocator) : held {allocator} {}
 
     /**
-     * Get the value at a given index from the bucket.
+     * Get the held allocator.
      *
-     * @param index index of value
-     * @return reference to value
+     * @return reference to the allocator
      */
-    reference operator[](size_type index);
+    const Allocator& allocator() const { return held; }
 
     /**
-     * Get the constant value at a given index from the bucket.
+     * Get the held allocator.
      *
-     * @param index index of value
-     * @return constant reference to value
+     * @return reference to the allocator
      */
-    const_reference operator[](size_type index) const;
+    Allocator& allocator() { return held; }
+};
+
+template<typename Allocator>
+class ADS_set_allocator_holder<Allocator, true> : Allocator {
+public:
+    explicit ADS_set_allocator_holder(const Allocator& allocator) : Allocator {allocator} {}
+
+    const Allocator& allocator() const { return *this; }
+
+    Allocator& allocator() { return *this; }
+};
+
+/**
+ * Statistics of a set returned by ADS_set::stats(). Counts of events are only collected if
+ * the traits enable stats and start at zero when the set is created or cleared.
+ */
+struct ADS_set_stats {
+    /** Amount of chain lengths with their own entry in the histogram, longer chains share the last entry */
+    static constexpr size_t histogram_size {16};
+
+    /** Amount of bucket splits */
+    size_t splits;
+
+    /** Amount of segment allocations, each doubling the capacity of the directory */
+    size_t doublings;
+
+    /** Bytes of values moved to other buckets by splits and merges */
+    size_t bytes_moved;
+
+    /** Amount of overflow pages added to buckets */
+    size_t expansions;
+
+    /** Amount of overflow pages in use */
+    size_t overflow_pages;
+
+    /** Amount of buckets with overflow pages */
+    size_t overflow_buckets;
+
+    /** Amount of buckets in use */
+    size_t buckets;
+
+    /** Maximum amount of overflow pages of a bucket */
+    size_t max_chain_length;
+
+    /** Mean amount of overflow pages of the buckets in use */
+    double mean_chain_length;
+
+    /** Amount of buckets per amount of overflow pages */
+    size_t chain_histogram[histogram_size];
+
+    /** Amount of lookups that found their key */
+    size_t hits;
+
+    /** Amount of lookups that didn't find their key */
+    size_t misses;
+
+    /** Values examined by lookups that found their key */
+    size_t hit_probes;
+
+    /** Values examined by lookups that didn't find their key */
+    size_t miss_probes;
+
+    /** Amount of lookups that didn't find their key, answered by the prefilter */
+    size_t filtered_misses;
+
+    /** Amount of values per bucket in use */
+    double load_factor;
+};
+
+/**
+ * Whether a function object accepts other types than the key type, which it marks with an is_transparent type.
+ *
+ * @tparam T type of function object
+ * @tparam K type of the looked up key, so lookups can depend on it
+ */
+template<typename T, typename K, typename = void>
+struct ADS_set_is_transparent : std::false_type {};
+
+template<typename T, typename K>
+struct ADS_set_is_transparent<T, K, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+/**
+ * Range of values given by a pair of iterators, usable in range-based for loops.
+ *
+ * @tparam Iterator type of iterator
+ */
+template<typename Iterator>
+struct ADS_set_range {
+    /** Iterator to the first value */
+    Iterator first;
+
+    /** Iterator after the last value */
+    Iterator last;
+
+    Iterator begin() const { return first; }
+
+    Iterator end() const { return last; }
+};
+
+/**
+ * Whether a type is a string, which is stored length-prefixed in saved sets.
+ *
+ * @tparam T type of key
+ */
+template<typename T>
+struct ADS_set_is_string : std::false_type {};
+
+template<typename Char, typename CharTraits, typename Allocator>
+struct ADS_set_is_string<std::basic_string<Char, CharTraits, Allocator>> : std::true_type {};
+
+/**
+ * Header of the files written by ADS_set::save(). It is followed by the offsets of the buckets'
+ * first values, one per bucket and one for the end, and the values. Keys are stored as they are,
+ * strings as records of their hash, their length and their characters padded to 8 bytes. Offsets
+ * count values for keys and bytes for strings, so the file holds no pointers.
+ */
+struct ADS_set_file_header {
+    /** Magic bytes of the format */
+    char magic[8];
+
+    /** Version of the format */
+    std::uint32_t version;
+
+    /** Whether the values are string records */
+    std::uint32_t strings;
+
+    /** Finalizer of the hashes, see ADS_set_mixer, since it selects the buckets of the keys */
+    std::uint32_t mixer;
+
+    /** Size of a hash in bytes, which selects the variant of the finalizer */
+    std::uint32_t hash_size;
+
+    /** Size of a key, or of a character for strings */
+    std::uint64_t key_size;
+
+    /** Split round (d in lectures) */
+    std::uint64_t split_round;
+
+    /** Index of next bucket that should be split (nextToSplit in lectures) */
+    std::uint64_t table_split_index;
+
+    /** Number of buckets in use */
+    std::uint64_t bucket_count;
+
+    /** Number of total values */
+    std::uint64_t items_size;
+
+    /** Size of the data behind the header in bytes */
+    std::uint64_t body_size;
+
+    /** FNV-1a hash of the data behind the header, continued with the header's fields before it */
+    std::uint64_t checksum;
+
+    /** Magic bytes every file starts with */
+    static constexpr char file_magic[8] {'A', 'D', 'S', '_', 's', 'e', 't', '\0'};
+
+    /** Current version of the format */
+    static constexpr std::uint32_t file_version {3};
+
+    /** Initial state of the checksum */
+    static constexpr std::uint64_t checksum_seed {0xCBF29CE484222325ull};
+
+    /**
+     * Continue the checksum with the given bytes.
+     *
+     * @param state checksum of the previous bytes
+     * @param data the bytes
+     * @param size amount of bytes
+     * @return checksum including the bytes
+     */
+    static std::uint64_t checksum_of(std::uint64_t state, const void* data, size_t size) {
+        const auto* bytes {static_cast<const unsigned char*>(data)};
+
+        for (size_t i {0}; i < size; ++i) {
+            state = (state ^ bytes[i]) * 0x100000001B3ull;
+        }
+
+        return state;
+    }
+
+    /**
+     * Get the checksum of the file, which continues the checksum of the body with the header's
+     * fields before the checksum, so a changed layout is detected as well.
+     *
+     * @param body_checksum checksum of the data behind the header
+     * @return checksum of the file
+     */
+    std::uint64_t file_checksum(std::uint64_t body_checksum) const {
+        return checksum_of(body_checksum, this, offsetof(ADS_set_file_header, checksum));
+    }
+};
+
+/**
+ * Buffered output of ADS_set::write(). Data is written in blocks, each prefixed by its raw and stored
+ * size, which are compressed with LZ4 if ADS_SET_WITH_LZ4 is defined. A checksum of the data follows
+ * the last block.
+ */
+class ADS_set_writer {
+public:
+    /** Amount of bytes buffered per block */
+    static constexpr size_t block_size {size_t {1} << 16};
+private:
+    /** The stream to write to */
+    std::ostream& stream;
+
+    /** Data of the current block */
+    unsigned char* buffer {new unsigned char[block_size]};
+
+    /** Amount of bytes in the current block */
+    size_t buffer_size {0};
+
+    /** FNV-1a hash of the data written so far */
+    std::uint64_t checksum {ADS_set_file_header::checksum_seed};
+
+    /**
+     * Write the current block to the stream.
+     */
+    void flush_block();
+
+public:
+    /**
+     * Creates a writer and writes the magic bytes and whether blocks are compressed.
+     *
+     * @param stream the stream to write to
+     */
+    explicit ADS_set_writer(std::ostream& stream);
+
+    ~ADS_set_writer() { delete[] buffer; }
+
+    ADS_set_writer(const ADS_set_writer&) = delete;
+
+    ADS_set_writer& operator=(const ADS_set_writer&) = delete;
+
+    /**
+     * Write bytes.
+     *
+     * @param data the bytes
+     * @param size amount of bytes
+     */
+    void write(const void* data, size_t size);
+
+    /**
+     * Write the last block, the end marker and the checksum.
+     *
+     * @throws std::runtime_error if the stream failed
+     */
+    void finish();
+};
+
+/**
+ * Buffered input of ADS_set::read(), reading the blocks of an ADS_set_writer.
+ */
+class ADS_set_reader {
+    /** The stream to read from */
+    std::istream& stream;
+
+    /** Data of the current block */
+    unsigned char* buffer {new unsigned char[ADS_set_writer::block_size]};
+
+    /** Amount of bytes in the current block */
+    size_t buffer_size {0};
+
+    /** Position of the next byte in the current block */
+    size_t buffer_position {0};
+
+    /** Whether blocks are compressed */
+    bool compressed {false};
+
+    /** FNV-1a hash of the data read so far */
+    std::uint64_t checksum {ADS_set_file_header::checksum_seed};
+
+    /**
+     * Read the next block from the stream.
+     *
+     * @throws std::runtime_error if the stream ended or the block is malformed
+     */
+    void fill_block();
+
+public:
+    /**
+     * Creates a reader, which reads the magic bytes and whether blocks are compressed.
+     *
+     * @param stream the stream to read from
+     * @throws std::runtime_error if the stream holds no written set
+     */
+    explicit ADS_set_reader(std::istream& stream);
+
+    ~ADS_set_reader() { delete[] buffer; }
+
+    ADS_set_reader(const ADS_set_reader&) = delete;
+
+    ADS_set_reader& operator=(const ADS_set_reader&) = delete;
+
+    /**
+     * Read bytes.
+     *
+     * @param data receives the bytes
+     * @param size amount of bytes
+     * @throws std::runtime_error if the data ended
+     */
+    void read(void* data, size_t size);
+
+    /**
+     * Read the end marker and the checksum and compare it with the data.
+     *
+     * @throws std::runtime_error if the data continues or the checksum doesn't match
+     */
+    void finish();
+};
+
+/**
+ * Writes and reads keys for ADS_set::write() and ADS_set::read(). Trivially copyable keys are
+ * written as they are and strings with their length, other keys require a specialization
+ * with the same members.
+ *
+ * @tparam Key key type
+ */
+template<typename Key, typename = void>
+struct ADS_set_serializer;
+
+template<typename Key>
+struct ADS_set_serializer<Key, std::enable_if_t<std::is_trivially_copyable_v<Key>>> {
+    static void write(ADS_set_writer& writer, const Key& key) { writer.write(&key, sizeof(Key)); }
+
+    static Key read(ADS_set_reader& reader) {
+        Key key;
+        reader.read(&key, sizeof(Key));
+
+        return key;
+    }
+};
+
+template<typename Char, typename CharTraits, typename Allocator>
+struct ADS_set_serializer<std::basic_string<Char, CharTraits, Allocator>> {
+    using string_type = std::basic_string<Char, CharTraits, Allocator>;
+
+    static void write(ADS_set_writer& writer, const string_type& key) {
+        const std::uint64_t length {key.size()};
+
+        writer.write(&length, sizeof(length));
+        writer.write(key.data(), key.size() * sizeof(Char));
+    }
+
+    static string_type read(ADS_set_reader& reader) {
+        std::uint64_t length;
+        reader.read(&length, sizeof(length));
+
+        string_type key;
+
+        // Grow the key with the read characters, so a corrupted length fails once the data ends
+        while (key.size() < length) {
+            const size_t chunk {std::min<std::uint64_t>(length - key.size(), ADS_set_writer::block_size / sizeof(Char))};
+            const size_t offset {key.size()};
+
+            key.resize(offset + chunk);
+            reader.read(&key[offset], chunk * sizeof(Char));
+        }
+
+        return key;
+    }
+};
+
+inline ADS_set_writer::ADS_set_writer(std::ostream& stream) : stream {stream} {
+#if defined(ADS_SET_WITH_LZ4)
+    const char compressed {1};
+#else
+    const char compressed {0};
+#endif
+
+    stream.write(ADS_set_file_header::file_magic, sizeof(ADS_set_file_header::file_magic));
+    stream.put(compressed);
+}
+
+inline void ADS_set_writer::flush_block() {
+    if (buffer_size == 0) return;
+
+    checksum = ADS_set_file_header::checksum_of(checksum, buffer, buffer_size);
+
+    std::uint32_t sizes[2] {static_cast<std::uint32_t>(buffer_size), static_cast<std::uint32_t>(buffer_size)};
+    const unsigned char* stored {buffer};
+
+#if defined(ADS_SET_WITH_LZ4)
+    static thread_local char compressed[LZ4_COMPRESSBOUND(block_size)];
+    const int compressed_size {LZ4_compress_default(reinterpret_cast<const char*>(buffer), compressed,
+                                                    static_cast<int>(buffer_size), sizeof(compressed))};
+
+    // Incompressible blocks are stored raw, which the equal sizes tell
+    if (compressed_size > 0 && static_cast<size_t>(compressed_size) < buffer_size) {
+        sizes[1] = static_cast<std::uint32_t>(compressed_size);
+        stored = reinterpret_cast<const unsigned char*>(compressed);
+    }
+#endif
+
+    stream.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    stream.write(reinterpret_cast<const char*>(stored), sizes[1]);
+    buffer_size = 0;
+}
+
+inline void ADS_set_writer::write(const void* data, size_t size) {
+    const auto* bytes {static_cast<const unsigned char*>(data)};
+
+    while (size > 0) {
+        const size_t chunk {size < block_size - buffer_size ? size : block_size - buffer_size};
+
+        std::memcpy(buffer + buffer_size, bytes, chunk);
+        buffer_size += chunk;
+        bytes += chunk;
+        size -= chunk;
+
+        if (buffer_size == block_size) flush_block();
+    }
+}
+
+inline void ADS_set_writer::finish() {
+    flush_block();
+
+    // A block of size 0 ends the data
+    const std::uint32_t end[2] {0, 0};
+
+    stream.write(reinterpret_cast<const char*>(end), sizeof(end));
+    stream.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    stream.flush();
+
+    if (!stream) throw std::runtime_error {"ADS_set: can't write set"};
+}
+
+inline ADS_set_reader::ADS_set_reader(std::istream& stream) : stream {stream} {
+    char magic[sizeof(ADS_set_file_header::file_magic)];
+    char flag {0};
+
+    stream.read(magic, sizeof(magic));
+    stream.get(flag);
+
+    if (!stream || std::memcmp(magic, ADS_set_file_header::file_magic, sizeof(magic)) != 0 || (flag != 0 && flag != 1)) {
+        delete[] buffer;
+        throw std::runtime_error {"ADS_set: stream holds no written set"};
+    }
+
+    compressed = flag == 1;
+
+#if !defined(ADS_SET_WITH_LZ4)
+    if (compressed) {
+        delete[] buffer;
+        throw std::runtime_error {"ADS_set: set was compressed with LZ4, define ADS_SET_WITH_LZ4 to read it"};
+    }
+#endif
+}
+
+inline void ADS_set_reader::fill_block() {
+    std::uint32_t sizes[2];
+    stream.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+
+    if (!stream || sizes[0] > ADS_set_writer::block_size || sizes[1] > sizes[0] || (sizes[0] == 0) != (sizes[1] == 0)) {
+        throw std::runtime_error {"ADS_set: malformed block"};
+    }
+
+    if (sizes[0] == 0) throw std::runtime_error {"ADS_set: data ended early"};
+
+    if (sizes[1] == sizes[0]) {
+        stream.read(reinterpret_cast<char*>(buffer), sizes[1]);
+    } else {
+#if defined(ADS_SET_WITH_LZ4)
+        static thread_local char stored[ADS_set_writer::block_size];
+        stream.read(stored, sizes[1]);
+
+        if (stream && LZ4_decompress_safe(stored, reinterpret_cast<char*>(buffer), static_cast<int>(sizes[1]),
+                                          static_cast<int>(sizes[0])) != static_cast<int>(sizes[0])) {
+            throw std::runtime_error {"ADS_set: malformed block"};
+        }
+#else
+        throw std::runtime_error {"ADS_set: malformed block"};
+#endif
+    }
+
+    if (!stream) throw std::runtime_error {"ADS_set: data ended early"};
+
+    buffer_size = sizes[0];
+    buffer_position = 0;
+    checksum = ADS_set_file_header::checksum_of(checksum, buffer, buffer_size);
+}
+
+inline void ADS_set_reader::read(void* data, size_t size) {
+    auto* bytes {static_cast<unsigned char*>(data)};
+
+    while (size > 0) {
+        if (buffer_position == buffer_size) fill_block();
+
+        const size_t chunk {size < buffer_size - buffer_position ? size : buffer_size - buffer_position};
+
+        std::memcpy(bytes, buffer + buffer_position, chunk);
+        buffer_position += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+}
+
+inline void ADS_set_reader::finish() {
+    std::uint32_t end[2];
+    std::uint64_t expected;
+
+    stream.read(reinterpret_cast<char*>(end), sizeof(end));
+    stream.read(reinterpret_cast<char*>(&expected), sizeof(expected));
+
+    if (!stream || buffer_position != buffer_size || end[0] != 0 || end[1] != 0) {
+        throw std::runtime_error {"ADS_set: data continues after the set"};
+    }
+
+    if (expected != checksum) throw std::runtime_error {"ADS_set: checksum doesn't match"};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits>
+class mapped_ADS_set;
+
+/**
+ * Set implemented with Linear hashing scheme.
+ *
+ * The buckets are stored flat: every bucket holds its first N values and their fingerprints
+ * inline, and the buckets of a segment are one contiguous array, so a probe that stays within
+ * N values touches a single bucket without following a pointer. Values beyond N go to overflow
+ * pages taken from a pool shared by all buckets.
+ *
+ * @tparam Key key type
+ * @tparam N size of the buckets (b in lectures), by default as many values as fit a cache
+ *           line, see ADS_set_default_bucket_size
+ * @tparam Hash hash function object
+ * @tparam KeyEqual equality function object, both of them are used for lookups of other
+ *                  key types if they declare is_transparent
+ * @tparam Traits compile-time options, see ADS_set_traits
+ * @tparam Allocator allocator of the buckets, overflow pages and bookkeeping, rebound to each of
+ *                   them; it has to hand out plain pointers, like std::allocator and
+ *                   std::pmr::polymorphic_allocator do
+ */
+template<typename Key, size_t N = ADS_set_default_bucket_size<Key>::value, typename Hash = std::hash<Key>,
+        typename KeyEqual = std::equal_to<Key>, typename Traits = ADS_set_traits<Key>,
+        typename Allocator = std::allocator<Key>>
+class ADS_set : ADS_set_counters<Traits::stats>, ADS_set_split_progress<(Traits::split_budget > 0)> {
+public:
+    class Bucket;
+
+    class Iterator;
+
+    using value_type = Key;
+    using key_type = Key;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_iterator = Iterator;
+    using iterator = const_iterator;
+    using key_equal = KeyEqual;
+    using hasher = Hash;
+    using allocator_type = Allocator;
+private:
+    class Block;
+
+    class Page;
+
+    class Pool;
+
+    /** Position of a value in its bucket together with the overflow page holding it */
+    struct Position {
+        /** Index of the value; if there is none the bucket's size */
+        size_type index;
+
+        /** Overflow page holding the value, nullptr for inline values or if there is none */
+        Page* page;
+    };
+
+    /** Whether fingerprints are stored alongside the values */
+    static constexpr bool has_fingerprints {Traits::fingerprint != ADS_set_fingerprint::none};
+
+    /** Whether splits move their values over many operations */
+    static constexpr bool splits_incrementally {Traits::split_budget > 0};
+
+    /** Alignment of the segments' buckets */
+    static constexpr size_type segment_alignment {alignof(Key) > ADS_set_default_bucket_size<Key>::cache_line_size ?
+                                                  alignof(Key) : ADS_set_default_bucket_size<Key>::cache_line_size};
+
+    /** Bytes of values compared at once by match_values() */
+    static constexpr size_type value_vector_size {16};
+
+    /** Whether the instruction set compares vectors of values */
+#if defined(ADS_SET_SIMD_AVX2) || defined(ADS_SET_SIMD_SSE2) || defined(ADS_SET_SIMD_NEON)
+    static constexpr bool has_value_vectors {true};
+#else
+    static constexpr bool has_value_vectors {false};
+#endif
+
+    /**
+     * Whether lookups compare the inline values a vector at a time instead of one after another.
+     * Integer keys of 4 or 8 bytes compared by == qualify if their inline values fill whole
+     * vectors and the bucket fits a cache line, so reading all of them touches no further line.
+     * Their inline storage is zeroed, so the values behind the bucket's size can be compared and
+     * masked afterwards.
+     */
+    static constexpr bool scans_inline_values {has_value_vectors && !has_fingerprints && std::is_integral_v<Key> &&
+                                               (sizeof(Key) == 4 || sizeof(Key) == 8) &&
+                                               N * sizeof(Key) % value_vector_size == 0 &&
+                                               ADS_set_default_bucket_size<Key>::bucket_bytes(N) <=
+                                               ADS_set_default_bucket_size<Key>::cache_line_size &&
+                                               (std::is_same_v<KeyEqual, std::equal_to<Key>> ||
+                                                std::is_same_v<KeyEqual, std::equal_to<>>)};
+
+    /**
+     * Compare a vector of values with a given key, only used if scans_inline_values.
+     *
+     * @param values the values to compare, value_vector_size bytes of them
+     * @param key the key to compare with
+     * @return mask with bit i set if the value at index i matches
+     */
+    static unsigned match_values(const unsigned char* values, const key_type& key);
+
+    /** Type of the fingerprints stored alongside the values */
+    using fingerprint_type = std::conditional_t<Traits::fingerprint == ADS_set_fingerprint::hash,
+            size_type, unsigned char>;
+
+    /** Amount of tags in a group */
+    static constexpr size_type tag_group_size {ADS_set_tag_group_size};
+
+    /**
+     * Get the amount of fingerprints stored for the given amount of values.
+     * Tags are padded to whole groups, so they can be compared without bounds checks.
+     *
+     * @param count amount of values
+     * @return amount of fingerprints
+     */
+    static constexpr size_type fingerprints_size(size_type count) {
+        if (Traits::fingerprint != ADS_set_fingerprint::tag) return count;
+
+        return (count + tag_group_size - 1) / tag_group_size * tag_group_size;
+    }
+
+    /**
+     * Compare a group of tags with a given tag.
+     *
+     * @param tags the tags to compare, tag_group_size of them
+     * @param tag the tag to compare with
+     * @return mask with bit i set if the tag at index i matches
+     */
+    static unsigned match_tags(const unsigned char* tags, unsigned char tag);
+
+    /**
+     * Compare two consecutive groups of tags with a given tag, AVX2 compares both in one vector.
+     *
+     * @param tags the tags to compare, 2 * tag_group_size of them
+     * @param tag the tag to compare with
+     * @return mask with bit i set if the tag at index i matches
+     */
+    static unsigned match_tag_pair(const unsigned char* tags, unsigned char tag);
+
+    /** Maximum amount of segments in the directory */
+    static constexpr size_type max_segments {sizeof(size_type) * CHAR_BIT};
+
+    /** Buckets are merged when the load falls below 1 / low_water_divisor of the capacity in use */
+    static constexpr size_type low_water_divisor {4};
+
+    /** Amount of keys hashed ahead of their insertion in range inserts */
+    static constexpr size_type hash_batch_size {16};
+
+    /** Saved sets and their mappings share the hashing of their keys */
+    friend class mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>;
+
+    /** Amount of buckets per word of the occupancy bitmaps */
+    static constexpr size_type occupancy_word_bits {sizeof(size_type) * CHAR_BIT};
+
+    /** Amount of keys per group of batched lookups, three groups are in flight at once */
+    static constexpr size_type probe_group_size {8};
+
+    /** Sets and ranges smaller than this are handled on the calling thread by the parallel operations */
+    static constexpr size_type parallel_min_size {size_type {1} << 16};
+
+    /** Amount of keys hashed by one task of a parallel insert */
+    static constexpr size_type parallel_chunk_size {size_type {1} << 14};
+
+    /** Amount of bucket ranges per thread of parallel operations, so uneven ranges even out */
+    static constexpr size_type ranges_per_thread {4};
+
+    /** Enables lookups with keys of type K if both hasher and key_equal are transparent */
+    template<typename K>
+    using transparent_key = std::enable_if_t<ADS_set_is_transparent<hasher, K>::value &&
+                                             ADS_set_is_transparent<key_equal, K>::value, int>;
+
+    /** Split round (d in lectures) */
+    size_type split_round {0};
+
+    /** Index of next bucket that should be split (nextToSplit in lectures) */
+    size_type table_split_index {0};
+
+    /** Number of buckets */
+    size_type table_size {0};
+
+    /** Number of total values stored in buckets */
+    size_type table_items_size {0};
+
+    /** Directory of segments, segment 0 holds buckets [0, 2) and segment k > 0 holds buckets [2^k, 2^(k + 1)) */
+    Bucket** segments {nullptr};
+
+    /**
+     * Occupancy bitmap per segment, bit i of word w is set if bucket w * occupancy_word_bits + i of the segment has values.
+     * With Traits::prefilter it is followed by a signature word per bucket of the segment.
+     */
+    size_type** occupancy {nullptr};
+
+    /** Index of the first bucket with values, only meaningful if the set isn't empty */
+    size_type first_occupied {0};
+
+    /** Pool of overflow pages for the buckets, which holds the allocator of all of the set's memory */
+    Pool pool;
+
+    /** Hash instance */
+    hasher hash {};
+
+    /** Key equality instance */
+    key_equal equal {};
+
+    /** Hash function for current split round */
+    size_type h(size_type key_hash) const {
+        return key_hash & ((size_type {1} << split_round) - 1);
+    }
+
+    /** Hash function for next split round */
+    size_type g(size_type key_hash) const {
+        return key_hash & ((size_type {2} << split_round) - 1);
+    }
+
+    /**
+     * Mix the bits of a hash with the configured finalizer.
+     *
+     * @param key_hash hash of the hash function object
+     * @return the mixed hash
+     */
+    static size_type mix(size_type key_hash);
+
+    /**
+     * Get the hash of a key, mixed with the configured finalizer.
+     *
+     * @tparam K type of key
+     * @param key the key to hash
+     * @return hash of the key
+     */
+    template<typename K>
+    size_type hash_of(const K& key) const { return mix(hash(key)); }
+
+    /**
+     * Get the fingerprint of a key's hash.
+     *
+     * @param key_hash hash of the key
+     * @return fingerprint to store alongside the key's value
+     */
+    static fingerprint_type fingerprint_of(size_type key_hash) {
+        if constexpr (Traits::fingerprint == ADS_set_fingerprint::tag) {
+            return static_cast<fingerprint_type>(key_hash >> (sizeof(size_type) * CHAR_BIT - CHAR_BIT));
+        } else {
+            return static_cast<fingerprint_type>(key_hash);
+        }
+    }
+
+    /**
+     * Get the floor of the binary logarithm of a value.
+     *
+     * @param value the value, greater than 0
+     * @return position of the most significant bit
+     */
+    static size_type floor_log2(size_type value) {
+        return sizeof(unsigned long long) * CHAR_BIT - 1 - __builtin_clzll(value);
+    }
+
+    /**
+     * Get the index of the segment that holds the bucket at the given index.
+     *
+     * @param index index of the bucket
+     * @return index of the segment
+     */
+    static size_type segment_of(size_type index);
+
+    /**
+     * Get the index of the first bucket in the given segment.
+     *
+     * @param segment index of the segment
+     * @return index of the segment's first bucket
+     */
+    static size_type segment_begin(size_type segment) { return segment == 0 ? 0 : size_type {1} << segment; }
+
+    /**
+     * Get the amount of buckets in the given segment.
+     *
+     * @param segment index of the segment
+     * @return amount of buckets in the segment
+     */
+    static size_type segment_size(size_type segment) { return segment == 0 ? 2 : size_type {1} << segment; }
+
+    /**
+     * Get the amount of words of a segment's occupancy bitmap.
+     *
+     * @param segment index of the segment
+     * @return amount of words
+     */
+    static size_type occupancy_words(size_type segment) {
+        return (segment_size(segment) + occupancy_word_bits - 1) / occupancy_word_bits;
+    }
+
+    /**
+     * Get the amount of words allocated per segment for its occupancy bitmap and signatures.
+     *
+     * @param segment index of the segment
+     * @return amount of words
+     */
+    static size_type bookkeeping_words(size_type segment) {
+        return occupancy_words(segment) + (Traits::prefilter ? segment_size(segment) : 0);
+    }
+
+    /**
+     * Get the signature bits of a hash. They are taken from the top of the product with a
+     * constant, so they depend on all bits of the hash and not on the bucket's low bits.
+     *
+     * @param key_hash the hash
+     * @return word with two bits set, or one if they coincide
+     */
+    static size_type signature_bits(size_type key_hash) {
+        const std::uint64_t product {static_cast<std::uint64_t>(key_hash) * 0x9e3779b97f4a7c15};
+
+        return (size_type {1} << (product >> 58)) | (size_type {1} << ((product >> 52) & 63));
+    }
+
+    /**
+     * Get the bucket at the given index.
+     *
+     * @param index index of the bucket
+     * @return reference to bucket
+     */
+    Bucket& bucket(size_type index) const;
+
+    /**
+     * Get the index of the first bucket with values in a range of buckets, scanning the
+     * occupancy bitmaps a word at a time.
+     *
+     * @param occupancy occupancy bitmaps of the segments
+     * @param from index of the first bucket to consider
+     * @param end index after the last bucket to consider, at most the table size
+     * @return index of the found bucket; if all buckets are empty end
+     */
+    static size_type next_occupied(const size_type* const* occupancy, size_type from, size_type end);
+
+    /**
+     * Set the occupancy bit of a bucket that got values.
+     *
+     * @param index index of the bucket
+     */
+    void mark_occupied(size_type index);
+
+    /**
+     * Update the occupancy bit of a bucket from its size.
+     *
+     * @param index index of the bucket
+     */
+    void update_occupancy(size_type index);
+
+    /**
+     * Rebuild the occupancy bitmaps from the sizes of all buckets.
+     */
+    void refresh_occupancy();
+
+    /**
+     * Get the signature of a bucket, a superset of the signature bits of its values. Only sets
+     * with Traits::prefilter have signatures.
+     *
+     * @param index index of the bucket
+     * @return reference to the signature
+     */
+    size_type& signature(size_type index) const;
+
+    /**
+     * Check the signatures of the bucket where a key's value should be at and of the bucket it
+     * might still wait in during a split.
+     *
+     * @param key_hash hash of the key
+     * @return false if the key surely isn't in the set
+     */
+    [[nodiscard]] bool may_contain(size_type key_hash) const;
+
+    /**
+     * Add a value's hash to the signature of its bucket.
+     *
+     * @param index index of the bucket
+     * @param key_hash hash of the value
+     */
+    void sign(size_type index, size_type key_hash);
+
+    /**
+     * Rebuild the signature of a bucket from its values, dropping the bits of erased values.
+     *
+     * @param index index of the bucket
+     */
+    void rebuild_signature(size_type index);
+
+    /**
+     * Rebuild the signatures of all buckets in use.
+     */
+    void refresh_signatures();
+
+    /**
+     * Free the buckets and occupancy bitmap of a segment. The prepared segment is freed as well,
+     * since it belongs to the doubling after the freed segments.
+     *
+     * @param segment index of the segment
+     */
+    void free_segment(size_type segment);
+
+    /**
+     * Construct more buckets of the segment of the next doubling and zero their bookkeeping
+     * words, allocating the segment first if none is prepared.
+     *
+     * @param count maximal amount of buckets to construct
+     */
+    void prepare_segment(size_type count);
+
+    /**
+     * Destroy the constructed buckets of the prepared segment and free it.
+     */
+    void release_prepared_segment();
+
+    /**
+     * Get the index of the bucket where a key's value should be at.
+     *
+     * @param key_hash hash of the key to probe for
+     * @return index of bucket
+     */
+    size_type bucket_index(size_type key_hash) const;
+
+    /**
+     * Get the hash of a stored value, which is read from its fingerprint if the full hash is stored.
+     *
+     * @param value the stored value
+     * @param fingerprint fingerprint of the value
+     * @return hash of the value
+     */
+    size_type hash_at(const value_type& value, fingerprint_type fingerprint) const;
+
+    /**
+     * Insert a value for a given key whose hash is already known. The value is only
+     * constructed if the key doesn't exist yet.
+     *
+     * @tparam K type of key
+     * @tparam Args types of the value's constructor arguments
+     * @param key the key to look up, the constructed value has to be equal to it
+     * @param key_hash hash of the key
+     * @param args arguments to construct the value with
+     * @return iterator for value and boolean whether it was newly added
+     */
+    template<typename K, typename... Args>
+    std::pair<Iterator, bool> emplace_hashed(const K& key, size_type key_hash, Args&&... args);
+
+    /**
+     * Allocates segments until the hash table holds the given amount of buckets.
+     * Existing buckets are never moved. This method will silently ignore smaller
+     * new table sizes. A prepared segment is completed and taken over.
+     *
+     * @param new_table_size
+     */
+    void reserve_buckets(size_type new_table_size);
+
+    /**
+     * Get the amount of buckets in use for the current split round and split index.
+     *
+     * @return amount of buckets in use
+     */
+    [[nodiscard]] size_type active_table_size() const { return (size_type {1} << split_round) + table_split_index; }
+
+    /**
+     * Split the next bucket that should be split. Its values are partitioned in place
+     * between the bucket and its partner bucket, which never triggers another split.
+     */
+    void split();
+
+    /**
+     * Merge the last split bucket with its partner, which is the inverse of split().
+     * The segment of the split round that is walked back is freed.
+     */
+    void merge();
+
+    /**
+     * Start an incremental split of the bucket at table_split_index. The partner bucket is in
+     * use right away, but the values move only as advance_splits() examines them.
+     */
+    void start_split();
+
+    /**
+     * Start an incremental split, or queue it behind the split in progress.
+     */
+    void queue_split();
+
+    /**
+     * Move values of the split in progress and start queued splits, examining at most the
+     * given amount of values.
+     *
+     * @param budget amount of values to examine
+     */
+    void advance_splits(size_type budget);
+
+    /**
+     * Complete the split in progress and all queued splits, so every value is in the bucket
+     * its hash selects.
+     */
+    void finish_splits();
+
+    /**
+     * Get the bucket whose split in progress moves values to the given bucket; those values may
+     * not have arrived yet.
+     *
+     * @param index index of a bucket
+     * @return index of the split bucket; if no split moves values to the bucket table_size
+     */
+    [[nodiscard]] size_type split_source(size_type index) const;
+
+    /**
+     * Find the value equal to the given key, also in the split bucket its value may still be in.
+     *
+     * @tparam K type of key
+     * @param key the key to find
+     * @param key_hash hash of the key
+     * @return index of the bucket and position of the value in it; if nothing was found the index
+     *         of the key's bucket and its size
+     */
+    template<typename K>
+    std::pair<size_type, Position> locate_key(const K& key, size_type key_hash) const;
+
+    /** Layout of a set given by its split state */
+    struct Layout {
+        /** Split round */
+        size_type split_round;
+
+        /** Index of next bucket that should be split */
+        size_type split_index;
+
+        /** Amount of buckets in use */
+        size_type buckets;
+    };
+
+    /**
+     * Get the layout of the set before the split in progress, in which every value is in the
+     * bucket its hash selects. Without a split in progress it is the current layout.
+     *
+     * @return the layout
+     */
+    [[nodiscard]] Layout settled_layout() const;
+
+    /**
+     * Call a function for every value that the given bucket holds in the settled layout. The split
+     * bucket holds the values of its partner bucket there.
+     *
+     * @tparam Visit type of function
+     * @param index index of a bucket of the settled layout
+     * @param visit function called with the value and its fingerprint
+     */
+    template<typename Visit>
+    void visit_settled(size_type index, Visit visit) const;
+
+    /**
+     * Get the amount of values the given bucket holds in the settled layout.
+     *
+     * @param index index of a bucket of the settled layout
+     * @return amount of values
+     */
+    [[nodiscard]] size_type settled_size(size_type index) const;
+
+    /**
+     * Removes the value equal to the given key.
+     *
+     * @tparam K type of key
+     * @param key the key to remove
+     * @return the amount of removed elements
+     */
+    template<typename K>
+    size_type erase_key(const K& key);
+
+    /**
+     * Removes the value equal to the given key whose hash is already known.
+     *
+     * @tparam K type of key
+     * @param key the key to remove
+     * @param key_hash hash of the key
+     * @return the amount of removed elements
+     */
+    template<typename K>
+    size_type erase_hashed(const K& key, size_type key_hash);
+
+    /**
+     * Count how many values are equal to the given key (0 or 1).
+     *
+     * @tparam K type of key
+     * @param key the key to count for
+     * @return how many times the key exists (0 or 1)
+     */
+    template<typename K>
+    size_type count_key(const K& key) const;
+
+    /**
+     * Finds the value equal to the given key.
+     *
+     * @tparam K type of key
+     * @param key the key to find
+     * @return iterator of found value; if nothing was found the end iterator
+     */
+    template<typename K>
+    iterator find_key(const K& key) const;
+
+    /**
+     * Count a lookup and the values it examined, if the traits enable stats.
+     *
+     * @param bucket the bucket of the looked up key
+     * @param index index of the found value; if it wasn't found the bucket's size
+     */
+    void count_lookup(const Bucket& bucket, size_type index) const;
+
+    /**
+     * Look up a batch of keys in a pipeline of three stages: hashing a group of keys and fetching
+     * their buckets, fetching the overflow pages of the previous group and comparing the keys of
+     * the group before that. Memory accesses of a group overlap with the work on the other two.
+     *
+     * @tparam Visit type of function
+     * @param keys the keys to look up
+     * @param count amount of keys
+     * @param visit function called with each key's position in the batch, the index of its
+     *              bucket and its position in the bucket, whose index is the bucket's size if it
+     *              wasn't found
+     */
+    template<typename Visit>
+    void probe_batch(const key_type* keys, size_type count, Visit visit) const;
+
+    /**
+     * Get the amount of low hash bits that select the bucket at the given index.
+     *
+     * @param index index of a bucket in use
+     * @return amount of bits
+     */
+    [[nodiscard]] size_type bucket_depth(size_type index) const {
+        const size_type depth {index < table_split_index || index >= (size_type {1} << split_round) ? split_round + 1 : split_round};
+
+        // The bucket being split still holds values of its partner bucket
+        if constexpr (splits_incrementally) {
+            if (this->split_progress().active && index == this->split_progress().from) return depth - 1;
+        }
+
+        return depth;
+    }
+
+    /**
+     * Get the bucket of another set that holds all values of one of this set's buckets. The bucket's
+     * index carries as many low hash bits as the bucket's depth, which pin down the other set's
+     * bucket if the other set doesn't select it by more bits.
+     *
+     * @param index index of a bucket in use
+     * @param other the other set
+     * @return index of the other set's bucket; if the values map to different buckets other.table_size
+     */
+    [[nodiscard]] size_type aligned_bucket(size_type index, const ADS_set& other) const;
+
+    /**
+     * Check whether one of this set's values exists in another set.
+     *
+     * @param value the value
+     * @param fingerprint fingerprint of the value
+     * @param aligned the other set's bucket from aligned_bucket()
+     * @param other the other set
+     * @return whether the other set holds an equal value
+     */
+    bool exists_in(const value_type& value, fingerprint_type fingerprint, size_type aligned, const ADS_set& other) const;
+
+    /**
+     * Remove all values that exist or don't exist in another set, merging buckets afterwards
+     * as long as the load is below the low-water mark.
+     *
+     * @param other the other set
+     * @param keep_existing whether values existing in the other set are kept
+     */
+    void retain(const ADS_set& other, bool keep_existing);
+
+    /**
+     * Merge buckets as long as the load is below the low-water mark, walking the layout back as
+     * far as single erases would have.
+     */
+    void merge_to_low_water();
+
+    /**
+     * Get the amount of bucket ranges parallel operations split the buckets in use into.
+     *
+     * @param threads the pool running the ranges
+     * @return amount of ranges
+     */
+    [[nodiscard]] size_type parallel_ranges(const ADS_thread_pool& threads) const;
+
+    /**
+     * Get the first bucket of a range of the buckets in use. Range r holds the buckets b
+     * with b * ranges / active_table_size() == r.
+     *
+     * @param range index of the range, ranges for the end of the last range
+     * @param ranges amount of ranges
+     * @return index of the range's first bucket
+     */
+    [[nodiscard]] size_type range_begin(size_type range, size_type ranges) const {
+        return (range * active_table_size() + ranges - 1) / ranges;
+    }
+
+    /**
+     * Check a predicate for all values, with the bucket ranges spread over the threads of a pool.
+     * The remaining values are skipped once the predicate failed.
+     *
+     * @tparam Predicate type of predicate
+     * @param predicate predicate called with each value, from many threads at once
+     * @param threads the pool to run on
+     * @return whether the predicate holds for all values
+     */
+    template<typename Predicate>
+    bool parallel_all_of(Predicate predicate, ADS_thread_pool& threads) const;
+
+    /**
+     * Check whether every value of this set is in the given other set.
+     *
+     * @param other the set to look the values up in
+     * @return whether all values are in the other set
+     */
+    bool contained_in(const ADS_set& other) const;
+
+    /**
+     * Swap the values, layout and function objects with those of the given other set, but not
+     * the allocators.
+     *
+     * @param other the set to swap with
+     */
+    void swap_contents(ADS_set& other);
+
+public:
+    /**
+     * Creates an empty set.
+     */
+    ADS_set();
+
+    /**
+     * Creates an empty set taking its memory from the given allocator.
+     *
+     * @param allocator the allocator
+     */
+    explicit ADS_set(const allocator_type& allocator);
+
+    /**
+     * Creates an empty set with the given function objects.
+     *
+     * @param hash the hash function object
+     * @param equal the equality function object
+     * @param allocator the allocator
+     */
+    explicit ADS_set(const hasher& hash, const key_equal& equal = key_equal {},
+                     const allocator_type& allocator = allocator_type {});
+
+    /**
+     * Delete the set.
+     */
+    ~ADS_set();
+
+    /**
+     * Creates a set with a given range of items.
+     *
+     * @tparam InputIt type of input iterator
+     * @param first first item in range
+     * @param last last item in range
+     */
+    template<typename InputIt>
+    ADS_set(InputIt first, InputIt last);
+
+    /**
+     * Creates a set with a given range of items, taking its memory from the given allocator.
+     *
+     * @tparam InputIt type of input iterator
+     * @param first first item in range
+     * @param last last item in range
+     * @param allocator the allocator
+     */
+    template<typename InputIt>
+    ADS_set(InputIt first, InputIt last, const allocator_type& allocator);
+
+    /**
+     * Creates an ADS_set with a given list of keys.
+     *
+     * @param ilist list of keys to initialize with
+     * @param allocator the allocator
+     */
+    ADS_set(std::initializer_list<key_type> ilist, const allocator_type& allocator = allocator_type {});
+
+    /**
+     * Creates a copy of a given set, with the allocator the other set's allocator selects for copies.
+     *
+     * @param other other set to copy from
+     */
+    ADS_set(const ADS_set& other);
+
+    /**
+     * Creates a copy of a given set taking its memory from the given allocator.
+     *
+     * @param other other set to copy from
+     * @param allocator the allocator
+     */
+    ADS_set(const ADS_set& other, const allocator_type& allocator);
+
+    /**
+     * Creates a set by moving values from other set, along with its allocator.
+     *
+     * @param other other set to move from
+     */
+    ADS_set(ADS_set&& other) noexcept;
+
+    /**
+     * Creates a set by moving values from other set, which are copied if the allocators differ.
+     *
+     * @param other other set to move from
+     * @param allocator the allocator
+     */
+    ADS_set(ADS_set&& other, const allocator_type& allocator);
+
+    /**
+     * Copies the values of other set to this set by assignment operator. The allocator is
+     * replaced by the other set's if it propagates on copy assignment.
+     *
+     * @param other other set to copy from
+     * @return reference to this set
+     */
+    ADS_set& operator=(const ADS_set& other);
+
+    /**
+     * Moves the values of other set to this set by assignment operator. The allocator is
+     * replaced by the other set's if it propagates on move assignment, otherwise the values are
+     * copied if the allocators differ.
+     *
+     * @param other other set to move from
+     * @return reference to this set
+     */
+    ADS_set& operator=(ADS_set&& other);
+
+    /**
+     * Copies the list of keys to this set by assignment operator.
+     *
+     * @param ilist list of keys to copy from
+     * @return reference to this set
+     */
+    ADS_set& operator=(std::initializer_list<key_type> ilist);
+
+    /**
+     * Insert a given key.
+     *
+     * @param key the key to insert
+     * @return iterator for value and boolean whether it was newly added
+     */
+    std::pair<iterator, bool> insert(const key_type& key);
+
+    /**
+     * Insert a given key by moving it, which only happens if it doesn't exist yet.
+     *
+     * @param key the key to insert
+     * @return iterator for value and boolean whether it was newly added
+     */
+    std::pair<iterator, bool> insert(key_type&& key);
+
+    /**
+     * Insert a key constructed in place from the given arguments.
+     *
+     * @tparam Args types of the key's constructor arguments
+     * @param args arguments to construct the key with
+     * @return iterator for value and boolean whether it was newly added
+     */
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args);
+
+    /**
+     * Insert a value constructed from the given arguments unless a value equal to the key exists.
+     * Nothing is constructed if the key already exists. Keys of other types than key_type
+     * require transparent hasher and key_equal.
+     *
+     * @tparam K type of key
+     * @tparam Args types of the value's constructor arguments
+     * @param key the key to look up, the constructed value has to be equal to it
+     * @param args arguments to construct the value with, the key itself if there are none
+     * @return iterator for value and boolean whether it was newly added
+     */
+    template<typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args);
+
+    /**
+     * Insert a range of given keys. Forward ranges reserve space for all keys up front
+     * and are hashed in batches ahead of their insertion.
+     *
+     * @tparam InputIt type of input iterator
+     * @param first first item in range
+     * @param last last item in range
+     */
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last);
+
+    /**
+     * Insert a given list of keys.
+     *
+     * @param ilist list of keys to insert
+     */
+    void insert(std::initializer_list<key_type> ilist);
+
+    /**
+     * Insert a range of given keys on the threads of a pool. The table is sized for the whole
+     * range first, then every thread hashes a part of the range and the keys are grouped by
+     * bucket ranges, which the threads fill without splitting. The hasher and key_equal are
+     * called from many threads at once. Small ranges are inserted on the calling thread.
+     *
+     * @tparam RandomIt type of random access iterator
+     * @param first first item in range
+     * @param last last item in range
+     * @param threads the pool to run on, the shared pool by default
+     */
+    template<typename RandomIt>
+    void parallel_insert(RandomIt first, RandomIt last, ADS_thread_pool& threads = ADS_thread_pool::shared());
+
+    /**
+     * Move all values of another set into this set, except for those that exist already.
+     * Buckets of both sets are matched by their index where the layouts line up, so most values
+     * are moved without hashing them again. Both sets have to hash keys equally.
+     *
+     * @param other the set to take the values from, empty afterwards
+     */
+    void merge(ADS_set&& other);
+
+    /**
+     * Remove all values that don't exist in another set. Both sets have to hash keys equally.
+     *
+     * @param other the set to intersect with
+     */
+    void intersect_with(const ADS_set& other);
+
+    /**
+     * Remove all values that exist in another set. Both sets have to hash keys equally.
+     *
+     * @param other the set to subtract
+     */
+    void difference_with(const ADS_set& other);
+
+    /**
+     * Count the values that exist in both this set and another set, probing the larger set with the
+     * values of the smaller one. Both sets have to hash keys equally.
+     *
+     * @param other the set to intersect with
+     * @return amount of common values
+     */
+    [[nodiscard]] size_type intersection_size(const ADS_set& other) const;
+
+    /**
+     * Clear all values of the set. The buckets and overflow pages are kept for reuse, so sets
+     * refilled after clearing don't allocate until they outgrow their previous size.
+     */
+    void clear();
+
+    /**
+     * Split buckets until the given amount of values fits into the inline storage of the buckets
+     * in use, so inserting them splits rarely. This method will silently ignore smaller counts.
+     *
+     * @param count the amount of values to reserve space for
+     */
+    void reserve(size_type count);
+
+    /**
+     * Merge buckets while the set stays at most half full and free unused memory.
+     */
+    void shrink_to_fit();
+
+    /**
+     * Move values of pending splits, when Traits::split_budget makes splits incremental. Idle
+     * phases can call this, so later inserts and erases find less work. Like inserts it needs
+     * external synchronization with other calls on the set.
+     *
+     * @param budget maximal amount of values to examine
+     * @return whether splits are still pending
+     */
+    bool maintenance(size_type budget);
+
+    /**
+     * Removes the given key from the hash table.
+     *
+     * @param key the key to remove
+     * @return the amount of removed elements
+     */
+    size_type erase(const key_type& key) { return erase_key(key); }
+
+    /**
+     * Removes the value equal to a key of another type, without converting it to key_type.
+     * Only available if hasher and key_equal are transparent.
+     *
+     * @tparam K type of key
+     * @param key the key to remove
+     * @return the amount of removed elements
+     */
+    template<typename K, transparent_key<K> = 0, std::enable_if_t<!std::is_convertible_v<const K&, iterator>, int> = 0>
+    size_type erase(const K& key) { return erase_key(key); }
+
+    /**
+     * Removes the values equal to a range of keys. Keys of forward ranges are hashed in batches
+     * and their buckets fetched before they are erased. The keys must not be values of this set.
+     *
+     * @tparam InputIt type of iterator
+     * @param first iterator to the first key
+     * @param last iterator after the last key
+     * @return the amount of removed elements
+     */
+    template<typename InputIt>
+    size_type erase(InputIt first, InputIt last);
+
+    /**
+     * Removes all values a predicate selects, walking the buckets once and compacting each of them
+     * in place. No memory is allocated, buckets are merged afterwards like single erases would.
+     *
+     * @tparam Predicate type of predicate
+     * @param predicate predicate called with each value, whether it is erased
+     * @return the amount of removed elements
+     */
+    template<typename Predicate>
+    size_type erase_if(Predicate predicate);
+
+    /**
+     * Count how many times a key exists in the set (0 or 1).
+     *
+     * @param key the key to count for
+     * @return how many times the key exists (0 or 1)
+     */
+    size_type count(const key_type& key) const { return count_key(key); }
+
+    /**
+     * Count how many values are equal to a key of another type (0 or 1).
+     * Only available if hasher and key_equal are transparent.
+     *
+     * @tparam K type of key
+     * @param key the key to count for
+     * @return how many times the key exists (0 or 1)
+     */
+    template<typename K, transparent_key<K> = 0>
+    size_type count(const K& key) const { return count_key(key); }
+
+    /**
+     * Finds the given key's value in the hash table.
+     *
+     * @param key the key to find
+     * @return iterator of found value; if nothing was found the end iterator
+     */
+    iterator find(const key_type& key) const { return find_key(key); }
+
+    /**
+     * Finds the value equal to a key of another type.
+     * Only available if hasher and key_equal are transparent.
+     *
+     * @tparam K type of key
+     * @param key the key to find
+     * @return iterator of found value; if nothing was found the end iterator
+     */
+    template<typename K, transparent_key<K> = 0>
+    iterator find(const K& key) const { return find_key(key); }
+
+    /**
+     * Check whether a key exists in the set.
+     *
+     * @param key the key to check
+     * @return whether the key exists
+     */
+    bool contains(const key_type& key) const { return count_key(key) != 0; }
+
+    /**
+     * Check whether a value equal to a key of another type exists in the set.
+     * Only available if hasher and key_equal are transparent.
+     *
+     * @tparam K type of key
+     * @param key the key to check
+     * @return whether the key exists
+     */
+    template<typename K, transparent_key<K> = 0>
+    bool contains(const K& key) const { return count_key(key) != 0; }
+
+    /**
+     * Count how many times each key of a batch exists in the set (0 or 1). The keys are hashed and
+     * their buckets fetched ahead of the comparisons, which hides the latency of the memory accesses.
+     *
+     * @param keys the keys to count for
+     * @param count amount of keys
+     * @param counts receives how many times each key exists (0 or 1)
+     */
+    void count_batch(const key_type* keys, size_type count, size_type* counts) const;
+
+    /**
+     * Find the values of a batch of keys, fetching their buckets ahead like count_batch().
+     *
+     * @param keys the keys to find
+     * @param count amount of keys
+     * @param found receives the iterator of each key's value; if nothing was found the end iterator
+     */
+    void find_batch(const key_type* keys, size_type count, iterator* found) const;
+
+    /**
+     * Check whether the keys of a batch exist in the set, fetching their buckets ahead like count_batch().
+     * Bit i % W of word i / W is set if key i exists, W being the amount of bits of size_type.
+     *
+     * @param keys the keys to check
+     * @param count amount of keys
+     * @param bits receives the bitmap, (count + W - 1) / W words which are overwritten
+     */
+    void contains_many(const key_type* keys, size_type count, size_type* bits) const;
+
+    /**
+     * Get the hash function object.
+     *
+     * @return copy of the hash function object
+     */
+    hasher hash_function() const { return hash; }
+
+    /**
+     * Get the equality function object.
+     *
+     * @return copy of the equality function object
+     */
+    key_equal key_eq() const { return equal; }
+
+    /**
+     * Get the allocator the set takes its memory from.
+     *
+     * @return copy of the allocator
+     */
+    allocator_type get_allocator() const { return pool.get_allocator(); }
+
+    /**
+     * Swap this set with the given other set. The allocators are swapped if they propagate on
+     * swap, otherwise they have to be equal.
+     *
+     * @param other the set to swap with
+     */
+    void swap(ADS_set& other);
+
+    /**
+     * Call a function for every value, with the bucket ranges spread over the threads of a pool.
+     * The function is called from many threads at once and must not modify the set.
+     *
+     * @tparam Function type of function
+     * @param function function called with each value
+     * @param threads the pool to run on, the shared pool by default
+     */
+    template<typename Function>
+    void parallel_for_each(Function function, ADS_thread_pool& threads = ADS_thread_pool::shared()) const;
+
+    /**
+     * Get the amount of buckets in use, which bucket ranges are taken from.
+     *
+     * @return amount of buckets in use
+     */
+    [[nodiscard]] size_type bucket_count() const { return active_table_size(); }
+
+    /**
+     * Get the values of a range of buckets. Disjoint bucket ranges can be walked by different
+     * threads at once, which lets scans be split over threads.
+     *
+     * @param first index of the first bucket
+     * @param last index after the last bucket, at most bucket_count()
+     * @return range of the values in the buckets
+     */
+    ADS_set_range<const_iterator> bucket_range(size_type first, size_type last) const {
+        return {Iterator {segments, occupancy, first, last, 0}, Iterator {segments, occupancy, last, last, 0}};
+    }
+
+    /**
+     * Get the iterator to the first item in the hash table.
+     *
+     * @return iterator to first item
+     */
+    const_iterator begin() const;
+
+    /**
+     * Get the Iterator after the last item in the hash table.
+     *
+     * @return Iterator after the last item
+     */
+    const_iterator end() const;
+
+    /**
+     * Get the total amount of stored values.
+     *
+     * @return total amount of stored values
+     */
+    [[nodiscard]] size_type size() const { return table_items_size; };
+
+    /**
+     * Get whether the set is empty.
+     *
+     * @return if set is empty
+     */
+    [[nodiscard]] bool empty() const { return table_items_size == 0; };
+
+    /**
+     * Dump the set's content to a given stream.
+     *
+     * @param o the stream to dump to
+     */
+    void dump(std::ostream& o = std::cerr) const;
+
+    /**
+     * Get the statistics of the set. The shape of the buckets is gathered by walking them,
+     * counted events are only available if the traits enable stats.
+     *
+     * @return the statistics
+     */
+    [[nodiscard]] ADS_set_stats stats() const;
+
+    /**
+     * Write the set to a file in the format of ADS_set_file_header, which mapped_ADS_set answers
+     * lookups from without loading it. Keys have to be trivially copyable or strings.
+     *
+     * @param path path of the file, which is replaced
+     * @throws std::runtime_error if the file can't be written
+     */
+    void save(const std::string& path) const;
+
+    /**
+     * Write the set to a stream, bucket by bucket with the split state and the fingerprints,
+     * so read() rebuilds the same table without hashing or splitting. Keys are written
+     * by ADS_set_serializer.
+     *
+     * @param stream the stream to write to
+     * @throws std::runtime_error if the stream failed
+     */
+    void write(std::ostream& stream) const;
+
+    /**
+     * Replace the values of the set with a set written by write(). The set is left unchanged
+     * if reading fails. The template arguments have to match those of the written set.
+     *
+     * @param stream the stream to read from
+     * @throws std::runtime_error if the stream holds no valid set of this type
+     */
+    void read(std::istream& stream);
+
+    friend bool operator==(const ADS_set& lhs, const ADS_set& rhs) {
+        if (lhs.table_items_size != rhs.table_items_size) return false;
+
+        return lhs.contained_in(rhs);
+    }
+
+    friend bool operator!=(const ADS_set& lhs, const ADS_set& rhs) {
+        return !(lhs == rhs);
+    }
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+class ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Block {
+    /** Storage for N values, which are constructed lazily */
+    alignas(value_type) unsigned char storage[N * sizeof(value_type)];
+
+public:
+    /**
+     * Creates storage without values, zeroed if lookups scan it as a whole.
+     */
+    Block() {
+        if constexpr (scans_inline_values) std::memset(storage, 0, sizeof(storage));
+    }
+
+    /**
+     * Get the raw storage of all values, including unused storage.
+     *
+     * @return pointer to the storage
+     */
+    const unsigned char* data() const { return storage; }
+
+    /**
+     * Get the raw storage of the value at a given index.
+     *
+     * @param index index of value
+     * @return pointer to the value's storage
+     */
+    void* raw(size_type index) { return storage + index * sizeof(value_type); }
+
+    /**
+     * Get the constructed value at a given index.
+     *
+     * @param index index of value
+     * @return reference to value
+     */
+    reference operator[](size_type index) {
+        return *std::launder(reinterpret_cast<value_type*>(raw(index)));
+    }
+
+    /**
+     * Get the constant constructed value at a given index.
+     *
+     * @param index index of value
+     * @return constant reference to value
+     */
+    const_reference operator[](size_type index) const {
+        return *std::launder(reinterpret_cast<const value_type*>(storage + index * sizeof(value_type)));
+    }
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+class ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Page {
+public:
+    /** Next older overflow page of the bucket */
+    Page* next {nullptr};
+
+    /** Next newer overflow page of the bucket, so the pages can be walked in the order of their values */
+    Page* newer {nullptr};
+
+    /**
+     * Get the amount of bytes needed for a page and its values and fingerprints.
+     *
+     * @param capacity amount of values of the page
+     * @return amount of bytes
+     */
+    static size_type bytes(size_type capacity);
+
+    /**
+     * Get the raw storage of the value at a given index. The values are stored
+     * right behind the page, followed by their fingerprints.
+     *
+     * @param index index of value
+     * @return pointer to the value's storage
+     */
+    void* raw(size_type index);
+
+    /**
+     * Get the fingerprints of the page's values.
+     *
+     * @param capacity amount of values of the page
+     * @return pointer to the first fingerprint
+     */
+    fingerprint_type* fingerprints(size_type capacity) {
+        return reinterpret_cast<fingerprint_type*>(static_cast<unsigned char*>(raw(0)) + fingerprints_offset(capacity));
+    }
+
+    /**
+     * Get the constant fingerprints of the page's values.
+     *
+     * @param capacity amount of values of the page
+     * @return pointer to the first fingerprint
+     */
+    const fingerprint_type* fingerprints(size_type capacity) const {
+        return const_cast<Page*>(this)->fingerprints(capacity);
+    }
+
+    /**
+     * Get the offset of the fingerprints from the first value.
+     *
+     * @param capacity amount of values of the page
+     * @return offset in bytes
+     */
+    static constexpr size_type fingerprints_offset(size_type capacity) {
+        return (capacity * sizeof(value_type) + alignof(fingerprint_type) - 1) / alignof(fingerprint_type) *
+               alignof(fingerprint_type);
+    }
+
+    /**
+     * Get the constructed value at a given index.
+     *
+     * @param index index of value
+     * @return reference to value
+     */
+    reference operator[](size_type index) {
+        return *std::launder(reinterpret_cast<value_type*>(raw(index)));
+    }
+
+    /**
+     * Get the constant constructed value at a given index.
+     *
+     * @param index index of value
+     * @return constant reference to value
+     */
+    const_reference operator[](size_type index) const {
+        return *std::launder(reinterpret_cast<const value_type*>(const_cast<Page*>(this)->raw(index)));
+    }
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+class ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool : public ADS_set_counters<Traits::stats>,
+                                                                  ADS_set_allocator_holder<Allocator> {
+    /** Amount of page classes, pages of class c hold N * 2^c values */
+    static constexpr size_type page_classes {Traits::overflow == ADS_set_overflow::geometric ? 32 : 1};
+
+    /** Amount of pages of class 0 allocated at once */
+    static constexpr size_type chunk_pages {32};
+
+    /** Alignment of chunks and pages */
+    static constexpr size_type alignment {alignof(value_type) > alignof(Page) ? alignof(value_type) : alignof(Page)};
+
+    /** Header of memory allocated at once, chained for freeing */
+    struct Chunk {
+        Chunk* next;
+
+        /** Amount of bytes of the chunk including the header */
+        size_type bytes;
+    };
+
+    /** Unit of raw memory with the given alignment, which the allocator is rebound to */
+    template<size_type Alignment>
+    struct Unit {
+        alignas(Alignment) unsigned char bytes[Alignment];
+    };
+
+    /** Allocator rebound to objects of type T */
+    template<typename T>
+    using rebound_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+    /** Allocated chunks */
+    Chunk* chunks {nullptr};
+
+    /** Next page of class 0 not handed out yet */
+    unsigned char* chunk_free {nullptr};
+
+    /** Amount of pages of class 0 not handed out yet */
+    size_type chunk_left {0};
+
+    /** Released pages available for reuse, one list per page class */
+    Page* free_pages[page_classes] {};
+
+    /**
+     * Allocate a chunk holding the given amount of bytes behind its header.
+     *
+     * @param bytes amount of bytes
+     * @return pointer to first byte behind the header
+     */
+    unsigned char* allocate_chunk(size_type bytes);
+
+public:
+    /**
+     * Get the amount of bytes needed for a page of the given class, rounded up to keep pages aligned.
+     *
+     * @param page_class class of the page
+     * @return amount of bytes
+     */
+    static size_type page_bytes(size_type page_class) {
+        return (Page::bytes(N << page_class) + alignment - 1) / alignment * alignment;
+    }
+
+    /**
+     * Creates an empty pool taking its memory from the given allocator.
+     *
+     * @param allocator the allocator
+     */
+    explicit Pool(const Allocator& allocator) : ADS_set_allocator_holder<Allocator> {allocator} {}
+
+    /**
+     * Delete the pool and all of its pages. Values in pages are not destroyed.
+     */
+    ~Pool();
+
+    Pool(const Pool& other) = delete;
+
+    Pool& operator=(const Pool& other) = delete;
+
+    /**
+     * Get the allocator the pool takes its memory from.
+     *
+     * @return reference to the allocator
+     */
+    const Allocator& get_allocator() const { return this->allocator(); }
+
+    /**
+     * Allocate uninitialized memory for objects from the pool's allocator.
+     *
+     * @tparam T type of objects
+     * @param count amount of objects
+     * @return pointer to the memory
+     */
+    template<typename T>
+    T* allocate_array(size_type count);
+
+    /**
+     * Return memory from allocate_array() to the pool's allocator.
+     *
+     * @tparam T type of objects
+     * @param array the memory, objects in it have to be destroyed already
+     * @param count amount of objects it was allocated for
+     */
+    template<typename T>
+    void deallocate_array(T* array, size_type count);
+
+    /**
+     * Allocate uninitialized memory with the given alignment from the pool's allocator.
+     *
+     * @tparam Alignment alignment of the memory
+     * @param bytes amount of bytes
+     * @return pointer to the memory
+     */
+    template<size_type Alignment>
+    unsigned char* allocate_bytes(size_type bytes) {
+        return reinterpret_cast<unsigned char*>(allocate_array<Unit<Alignment>>((bytes + Alignment - 1) / Alignment));
+    }
+
+    /**
+     * Return memory from allocate_bytes() to the pool's allocator.
+     *
+     * @tparam Alignment alignment the memory was allocated with
+     * @param memory the memory
+     * @param bytes amount of bytes it was allocated for
+     */
+    template<size_type Alignment>
+    void deallocate_bytes(unsigned char* memory, size_type bytes) {
+        deallocate_array(reinterpret_cast<Unit<Alignment>*>(memory), (bytes + Alignment - 1) / Alignment);
+    }
+
+    /**
+     * Swap the allocator with the allocator of the given other pool.
+     *
+     * @param other the pool to swap with
+     */
+    void swap_allocator(Pool& other) {
+        using std::swap;
+
+        swap(this->allocator(), other.allocator());
+    }
+
+    /**
+     * Get an empty page of the given class from the pool.
+     *
+     * @param page_class class of the page
+     * @return pointer to page
+     */
+    Page* allocate(size_type page_class);
+
+    /**
+     * Return a page whose values have been destroyed to the pool.
+     *
+     * @param page the page to return
+     * @param page_class class of the page
+     */
+    void release(Page* page, size_type page_class);
+
+    /**
+     * Get whether the pool holds pages that are not handed out.
+     *
+     * @return if pool has unused pages
+     */
+    [[nodiscard]] bool has_free_pages() const;
+
+    /**
+     * Swap this pool with the given other pool.
+     *
+     * @param other the pool to swap with
+     */
+    void swap(Pool& other);
+
+    /**
+     * Take over all pages of the given other pool, including the pages handed out by it.
+     * Its pages not handed out yet become released pages of this pool.
+     *
+     * @param other the pool to take the pages from, empty afterwards
+     */
+    void adopt(Pool& other);
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+class ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket : ADS_set_fingerprints<fingerprint_type, fingerprints_size(N), has_fingerprints> {
+    using Fingerprints = ADS_set_fingerprints<fingerprint_type, fingerprints_size(N), has_fingerprints>;
+
+    /** Amount of stored values */
+    size_type values_size {0};
+
+    /** First N values, stored inline */
+    Block values;
+
+    /** Overflow pages holding the values beyond the first N, starting with the newest page */
+    Page* overflow {nullptr};
+
+    /**
+     * Get the number of the overflow page that holds the value at a given index.
+     *
+     * @param index index of value, at least N
+     * @return number of page, the oldest page being 0
+     */
+    static size_type page_number(size_type index);
+
+    /**
+     * Get the index of the first value of the given overflow page.
+     *
+     * @param number number of page
+     * @return index of the page's first value
+     */
+    static size_type page_begin(size_type number);
+
+    /**
+     * Get the amount of values the given overflow page holds.
+     *
+     * @param number number of page
+     * @return capacity of the page
+     */
+    static size_type page_capacity(size_type number) {
+        return Traits::overflow == ADS_set_overflow::geometric ? N << number : N;
+    }
+
+    /**
+     * Get the class of the given overflow page.
+     *
+     * @param number number of page
+     * @return class of the page
+     */
+    static size_type page_class(size_type number) {
+        return Traits::overflow == ADS_set_overflow::geometric ? number : 0;
+    }
+
+    /**
+     * Get the overflow page with the given number.
+     *
+     * @param number number of page
+     * @return pointer to page
+     */
+    Page* page(size_type number) const;
+
+    /**
+     * Find a value in a block of values, comparing fingerprints before keys.
+     * Tags are compared a whole vector at a time.
+     *
+     * @tparam Equal type of predicate
+     * @param fingerprints fingerprints of the values
+     * @param count amount of values
+     * @param fingerprint fingerprint to look for
+     * @param equal predicate whether the value at a given index equals the key
+     * @return index of the found value; if it wasn't found count
+     */
+    template<typename Equal>
+    static size_type find_in(const fingerprint_type* fingerprints, size_type count, fingerprint_type fingerprint,
+                             Equal equal);
+
+    /**
+     * Expand the capacity of Bucket by a new overflow page from the pool.
+     *
+     * @param pool the pool to take the page from
+     */
+    void expand(Pool& pool);
+
+    /**
+     * Destroy the last value and return its page to the pool if it became empty.
+     *
+     * @param pool the pool to return pages to
+     */
+    void pop_back(Pool& pool);
+
+    /**
+     * Get the page holding the value before a given one in O(1) from the page holding that value.
+     *
+     * @param index index of value, at least 1
+     * @param current page holding the value, nullptr for inline values
+     * @return page holding the value at index - 1
+     */
+    Page* page_before(size_type index, Page* current) const {
+        if (index == N) return nullptr;
+
+        return index > N && index == page_begin(page_number(index)) ? current->next : current;
+    }
+
+public:
+    /**
+     * Creates an empty bucket.
+     */
+    Bucket() = default;
+
+    /**
+     * Delete this bucket's values. Overflow pages are owned by the pool.
+     */
+    ~Bucket();
+
+    Bucket(const Bucket& other) = delete;
+
+    /**
+     * Creates a bucket by moving values from other bucket.
+     *
+     * @param other other bucket to move from
+     */
+    Bucket(Bucket&& other) noexcept;
+
+    Bucket& operator=(const Bucket& other) = delete;
+
+    /**
+     * Get the amount of overflow pages in use.
+     *
+     * @return amount of pages
+     */
+    [[nodiscard]] size_type page_count() const { return values_size <= N ? 0 : page_number(values_size - 1) + 1; }
+
+    /**
+     * Get the value at a given index from the bucket. Its page is looked up from the newest page
+     * on, walks over the values use at() with page_after() instead.
+     *
+     * @param index index of value
+     * @return reference to value
+     */
+    reference operator[](size_type index) { return at(index, page_of(index)); }
+
+    /**
+     * Get the constant value at a given index from the bucket.
+     *
+     * @param index index of value
+     * @return constant reference to value
+     */
+    const_reference operator[](size_type index) const { return at(index, page_of(index)); }
+
+    /**
+     * Get the fingerprint of the value at a given index.
+     *
+     * @param index index of value
+     * @return fingerprint of value
+     */
+    fingerprint_type fingerprint(size_type index) const { return fingerprint_at(index, page_of(index)); }
+
+    /**
+     * Get the overflow page holding the value at a given index, walking from the newest page.
+     *
+     * @param index index of value
+     * @return pointer to page; nullptr for inline values
+     */
+    Page* page_of(size_type index) const { return index < N ? nullptr : page(page_number(index)); }
+
+    /**
+     * Get the page holding the value after a given one in O(1) from the page holding that value,
+     * so walks over the values don't look up every page from the newest one on.
+     *
+     * @param index index of value
+     * @param current page holding the value, nullptr for inline values
+     * @return page holding the value at index + 1
+     */
+    Page* page_after(size_type index, Page* current) const;
+
+    /**
+     * Get the value at a given index from the page holding it.
+     *
+     * @param index index of value
+     * @param current page holding the value, nullptr for inline values
+     * @return reference to value
+     */
+    reference at(size_type index, Page* current) {
+        return index < N ? values[index] : (*current)[index - page_begin(page_number(index))];
+    }
+
+    /**
+     * Get the constant value at a given index from the page holding it.
+     *
+     * @param index index of value
+     * @param current page holding the value, nullptr for inline values
+     * @return constant reference to value
+     */
+    const_reference at(size_type index, const Page* current) const {
+        return index < N ? values[index] : (*current)[index - page_begin(page_number(index))];
+    }
+
+    /**
+     * Get the fingerprint of the value at a given index from the page holding it.
+     *
+     * @param index index of value
+     * @param current page holding the value, nullptr for inline values
+     * @return fingerprint of value
+     */
+    fingerprint_type fingerprint_at(size_type index, const Page* current) const;
+
+    /**
+     * Call a function for every value in the order of their indices, walking the overflow pages
+     * one after another.
+     *
+     * @tparam Visit type of function
+     * @param visit function called with the value and its fingerprint
+     */
+    template<typename Visit>
+    void for_each(Visit visit);
+
+    /**
+     * Call a function for every constant value in the order of their indices.
+     *
+     * @tparam Visit type of function
+     * @param visit function called with the value and its fingerprint
+     */
+    template<typename Visit>
+    void for_each(Visit visit) const;
+
+    /**
+     * Get the index of a stored key's value in the bucket. Keys are only
+     * compared if their fingerprints match.
+     *
+     * @tparam K type of key
+     * @param key the key to find
+     * @param fingerprint fingerprint of the key
+     * @param equal the equality function object
+     * @return position of the found element, so it's not looked up again; if it wasn't found its
+     *         index is the size of the bucket
+     */
+    template<typename K>
+    Position index_of(const K& key, fingerprint_type fingerprint, const key_equal& equal) const;
+
+    /**
+     * Locate the value stored with the given key.
+     *
+     * @tparam K type of key
+     * @param key the key to locate for
+     * @param fingerprint fingerprint of the key
+     * @param equal the equality function object
+     * @return pointer to found value; if nothing was found nullptr
+     */
+    template<typename K>
+    const value_type* locate(const K& key, fingerprint_type fingerprint, const key_equal& equal) const;
+
+    /**
+     * Start fetching the bucket into the cache, which holds the inline values and their fingerprints.
+     */
+    void prefetch() const {
+        __builtin_prefetch(this);
+
+        if constexpr (sizeof(Bucket) > 64) {
+            __builtin_prefetch(reinterpret_cast<const unsigned char*>(this) + sizeof(Bucket) - 1);
+        }
+    }
+
+    /**
+     * Start fetching the newest overflow page into the cache, which is searched first after the inline values.
+     */
+    void prefetch_overflow() const;
+
+    /**
+     * Construct a value at the end of the bucket without checking if it already exists.
+     *
+     * @tparam Args types of the value's constructor arguments
+     * @param fingerprint fingerprint of the value
+     * @param pool the pool to take overflow pages from
+     * @param args arguments to construct the value with
+     */
+    template<typename... Args>
+    void emplace_back(fingerprint_type fingerprint, Pool& pool, Args&&... args);
+
+    /**
+     * Count how many times a key exists in the bucket (0 or 1 times):
+     *
+     * @tparam K type of key
+     * @param key the key to count for
+     * @param fingerprint fingerprint of the key
+     * @param equal the equality function object
+     * @return how many times the key exists (0 or 1)
+     */
+    template<typename K>
+    size_type count(const K& key, fingerprint_type fingerprint, const key_equal& equal) const;
+
+    /**
+     * Remove item with key from the bucket.
+     *
+     * @tparam K type of key
+     * @param key they key to remove
+     * @param fingerprint fingerprint of the key
+     * @param equal the equality function object
+     * @param pool the pool to return emptied pages to
+     * @return how many items were removed (0 or 1)
+     */
+    template<typename K>
+    size_type erase(const K& key, fingerprint_type fingerprint, const key_equal& equal, Pool& pool);
+
+    /**
+     * Remove the value at an index by replacing it with the last value, given the page holding it.
+     *
+     * @param index index of the value to remove
+     * @param current page holding the value, nullptr for inline values
+     * @param pool the pool to return emptied pages to
+     */
+    void remove_at(size_type index, Page* current, Pool& pool);
+
+    /**
+     * Move all values selected by a predicate to another bucket, keeping the others in place.
+     * Keys are moved without duplicate checks, since they are unique already.
+     *
+     * @tparam Predicate type of predicate
+     * @param moves predicate whether a value with a given fingerprint moves
+     * @param target the bucket to move the values to
+     * @param pool the pool to take and return overflow pages
+     */
+    template<typename Predicate>
+    void partition(Predicate moves, Bucket& target, Pool& pool);
+
+    /**
+     * Move values selected by a predicate to another bucket like partition(), but examine only
+     * a limited amount of values. Values before the start index have been examined already.
+     *
+     * @tparam Predicate type of predicate
+     * @param moves predicate whether a value with a given fingerprint moves
+     * @param target the bucket to move the values to
+     * @param pool the pool to take and return overflow pages
+     * @param begin index of the first value to examine
+     * @param count maximal amount of values to examine
+     * @return index of the first value that wasn't examined
+     */
+    template<typename Predicate>
+    size_type partition_some(Predicate moves, Bucket& target, Pool& pool, size_type begin, size_type count);
+
+    /**
+     * Remove all values selected by a predicate.
+     *
+     * @tparam Predicate type of predicate
+     * @param removes predicate whether a value with a given fingerprint is removed
+     * @param pool the pool to return emptied pages to
+     * @return how many values were removed
+     */
+    template<typename Predicate>
+    size_type remove_if(Predicate removes, Pool& pool);
+
+    /**
+     * Copy all values of another bucket to the end of the bucket, keeping their order and fingerprints.
+     *
+     * @param other the bucket to copy
+     * @param pool the pool to take overflow pages from
+     */
+    void append(const Bucket& other, Pool& pool);
+
+    /**
+     * Remove all values from the bucket.
+     *
+     * @param pool the pool to return the overflow pages to
+     */
+    void clear(Pool& pool);
+
+    /**
+     * Move the overflow values into pages of another pool.
+     *
+     * @param pool the pool to take the new pages from
+     */
+    void relocate(Pool& pool);
+
+    /**
+     * Get the amount of stored values.
+     *
+     * @return amount of stored values
+     */
+    [[nodiscard]] size_type size() const { return values_size; }
+
+    /**
+     * Get the amount of available values.
+     *
+     * @return amount of available values
+     */
+    [[nodiscard]] size_type capacity() const { return values_size <= N ? N : page_begin(page_count()); }
+
+    /**
+     * Get whether the bucket is full.
+     *
+     * @return if bucket is full
+     */
+    [[nodiscard]] size_type full() const { return values_size == capacity(); }
+
+    /**
+     * Dump the bucket's content to a given stream.
+     *
+     * @param o the stream to dump to
+     */
+    void dump(std::ostream& o = std::cerr) const;
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+class ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator {
+public:
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using reference = const value_type&;
+    using pointer = const value_type*;
+    using iterator_category = std::forward_iterator_tag;
+private:
+    using bucket_pointer = typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket*;
+    using bucket_size_type = typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type;
+    using page_pointer = typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Page*;
+
+    /** Directory of segments */
+    const bucket_pointer* segments {nullptr};
+
+    /** Occupancy bitmaps of the segments */
+    const bucket_size_type* const* occupancy {nullptr};
+
+    /** Pointer to current bucket */
+    bucket_pointer current {nullptr};
+
+    /** Index of current bucket */
+    bucket_size_type bucket_index {0};
+
+    /** Index of end bucket */
+    bucket_size_type end {0};
+
+    /** Index of current value in current bucket */
+    bucket_size_type index {0};
+
+    /** Overflow page holding the current value, nullptr for inline values */
+    page_pointer page {nullptr};
+
+    /**
+     * Advance to the first bucket with values at or after the given one, or to the end bucket.
+     *
+     * @param from index of the first bucket to consider
+     */
+    void seek(bucket_size_type from);
+
+public:
+    /**
+     * Default constructor
+     */
+    Iterator() = default;
+
+    /**
+     * Creates iterator with current and end bucket and index to current value.
+     *
+     * @param segments directory of segments
+     * @param occupancy occupancy bitmaps of the segments
+     * @param bucket_index index of current bucket
+     * @param end index of end bucket
+     * @param index index to current value in current bucket
+     */
+    explicit Iterator(const bucket_pointer* segments, const bucket_size_type* const* occupancy,
+                      bucket_size_type bucket_index, bucket_size_type end, bucket_size_type index);
+
+    /**
+     * Creates iterator to a found value with the overflow page holding it, so the page isn't
+     * looked up again.
+     *
+     * @param segments directory of segments
+     * @param occupancy occupancy bitmaps of the segments
+     * @param bucket_index index of current bucket
+     * @param end index of end bucket
+     * @param index index to current value in current bucket, less than the bucket's size
+     * @param page overflow page holding the current value, nullptr for inline values
+     */
+    explicit Iterator(const bucket_pointer* segments, const bucket_size_type* const* occupancy,
+                      bucket_size_type bucket_index, bucket_size_type end, bucket_size_type index,
+                      page_pointer page);
+
+    reference operator*() const;
+
+    pointer operator->() const;
+
+    Iterator& operator++();
+
+    Iterator operator++(int);
+
+    friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+        return lhs.segments == rhs.segments && lhs.bucket_index == rhs.bucket_index &&
+               lhs.index == rhs.index;
+    }
+
+    friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+        return !(lhs == rhs);
+    }
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+unsigned ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::match_tags(const unsigned char* tags, unsigned char tag) {
+#if defined(ADS_SET_SIMD_AVX2) || defined(ADS_SET_SIMD_SSE2)
+    const __m128i block {_mm_loadu_si128(reinterpret_cast<const __m128i*>(tags))};
+
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(tag)))));
+#elif defined(ADS_SET_SIMD_NEON)
+    // Weigh matching lanes by their bit and add them up per half to form the mask
+    static const uint8_t weights[16] {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t matches {vandq_u8(vceqq_u8(vld1q_u8(tags), vdupq_n_u8(tag)), vld1q_u8(weights))};
+
+    return vaddv_u8(vget_low_u8(matches)) | static_cast<unsigned>(vaddv_u8(vget_high_u8(matches))) << 8;
+#else
+    unsigned matches {0};
+
+    for (size_type i {0}; i < tag_group_size; ++i) {
+        matches |= static_cast<unsigned>(tags[i] == tag) << i;
+    }
+
+    return matches;
+#endif
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+unsigned ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::match_tag_pair(const unsigned char* tags, unsigned char tag) {
+#if defined(ADS_SET_SIMD_AVX2)
+    const __m256i block {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags))};
+
+    return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(static_cast<char>(tag)))));
+#else
+    return match_tags(tags, tag) | match_tags(tags + tag_group_size, tag) << tag_group_size;
+#endif
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+unsigned ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::match_values(const unsigned char* values, const key_type& key) {
+#if defined(ADS_SET_SIMD_AVX2) || defined(ADS_SET_SIMD_SSE2)
+    const __m128i block {_mm_loadu_si128(reinterpret_cast<const __m128i*>(values))};
+
+    if constexpr (sizeof(key_type) == 4) {
+        const __m128i matches {_mm_cmpeq_epi32(block, _mm_set1_epi32(static_cast<int>(key)))};
+
+        return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(matches)));
+    } else {
+        // Values match if both of their halves match
+        const __m128i halves {_mm_cmpeq_epi32(block, _mm_set1_epi64x(static_cast<long long>(key)))};
+        const __m128i matches {_mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)))};
+
+        return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(matches)));
+    }
+#elif defined(ADS_SET_SIMD_NEON)
+    // Weigh matching lanes by their bit and add them up to form the mask
+    if constexpr (sizeof(key_type) == 4) {
+        static const uint32_t weights[4] {1, 2, 4, 8};
+        const uint32x4_t matches {vceqq_u32(vld1q_u32(reinterpret_cast<const uint32_t*>(values)),
+                                            vdupq_n_u32(static_cast<uint32_t>(key)))};
+
+        return vaddvq_u32(vandq_u32(matches, vld1q_u32(weights)));
+    } else {
+        static const uint64_t weights[2] {1, 2};
+        const uint64x2_t matches {vceqq_u64(vld1q_u64(reinterpret_cast<const uint64_t*>(values)),
+                                            vdupq_n_u64(static_cast<uint64_t>(key)))};
+
+        return static_cast<unsigned>(vaddvq_u64(vandq_u64(matches, vld1q_u64(weights))));
+    }
+#else
+    unsigned matches {0};
+
+    for (size_type i {0}; i < value_vector_size / sizeof(key_type); ++i) {
+        key_type value;
+        std::memcpy(&value, values + i * sizeof(key_type), sizeof(key_type));
+        matches |= static_cast<unsigned>(value == key) << i;
+    }
+
+    return matches;
+#endif
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::mix(size_type key_hash) {
+    if constexpr (Traits::mixer == ADS_set_mixer::fmix && sizeof(size_type) == 8) {
+        unsigned long long mixed {key_hash};
+
+        mixed ^= mixed >> 33;
+        mixed *= 0xFF51AFD7ED558CCDull;
+        mixed ^= mixed >> 33;
+        mixed *= 0xC4CEB9FE1A85EC53ull;
+        mixed ^= mixed >> 33;
+
+        return static_cast<size_type>(mixed);
+    } else if constexpr (Traits::mixer == ADS_set_mixer::fmix) {
+        unsigned long mixed {key_hash};
+
+        mixed ^= mixed >> 16;
+        mixed = (mixed * 0x85EBCA6Bul) & 0xFFFFFFFFul;
+        mixed ^= mixed >> 13;
+        mixed = (mixed * 0xC2B2AE35ul) & 0xFFFFFFFFul;
+        mixed ^= mixed >> 16;
+
+        return static_cast<size_type>(mixed);
+    } else {
+        return key_hash;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::segment_of(size_type index) {
+    if (index < 2) return 0;
+
+    // The segment is the position of the index's most significant bit
+    return floor_log2(index);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket& ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::bucket(size_type index) const {
+    const size_type segment {segment_of(index)};
+
+    return segments[segment][index - segment_begin(segment)];
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::next_occupied(const size_type* const* occupancy, size_type from, size_type end) {
+    while (from < end) {
+        const size_type segment {segment_of(from)};
+        const size_type offset {from - segment_begin(segment)};
+        const size_type word {occupancy[segment][offset / occupancy_word_bits] >> (offset % occupancy_word_bits)};
+
+        if (word != 0) {
+            const size_type found {from + static_cast<size_type>(__builtin_ctzll(word))};
+
+            return found < end ? found : end;
+        }
+
+        // Continue with the next word, which might be in the next segment
+        const size_type word_end {from - offset % occupancy_word_bits + occupancy_word_bits};
+        const size_type segment_end {segment_begin(segment) + segment_size(segment)};
+
+        from = word_end < segment_end ? word_end : segment_end;
+    }
+
+    return end;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::mark_occupied(size_type index) {
+    const size_type segment {segment_of(index)};
+    const size_type offset {index - segment_begin(segment)};
+
+    occupancy[segment][offset / occupancy_word_bits] |= size_type {1} << (offset % occupancy_word_bits);
+
+    if (table_items_size == 0 || index < first_occupied) first_occupied = index;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::update_occupancy(size_type index) {
+    if (bucket(index).size() != 0) {
+        mark_occupied(index);
+        return;
+    }
+
+    const size_type segment {segment_of(index)};
+    const size_type offset {index - segment_begin(segment)};
+
+    occupancy[segment][offset / occupancy_word_bits] &= ~(size_type {1} << (offset % occupancy_word_bits));
+
+    if (index == first_occupied) first_occupied = next_occupied(occupancy, index + 1, table_size);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::refresh_occupancy() {
+    for (size_type segment {0}; segment < max_segments && segments[segment] != nullptr; ++segment) {
+        for (size_type offset {0}; offset < segment_size(segment); offset += occupancy_word_bits) {
+            size_type word {0};
+
+            for (size_type i {offset}; i < segment_size(segment) && i < offset + occupancy_word_bits; ++i) {
+                word |= static_cast<size_type>(segments[segment][i].size() != 0) << (i - offset);
+            }
+
+            occupancy[segment][offset / occupancy_word_bits] = word;
+        }
+    }
+
+    first_occupied = next_occupied(occupancy, 0, table_size);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type& ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::signature(size_type index) const {
+    const size_type segment {segment_of(index)};
+
+    return occupancy[segment][occupancy_words(segment) + index - segment_begin(segment)];
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+bool ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::may_contain(size_type key_hash) const {
+    if constexpr (Traits::prefilter) {
+        const size_type bits {signature_bits(key_hash)};
+        const size_type index {bucket_index(key_hash)};
+
+        if ((signature(index) & bits) == bits) return true;
+
+        const size_type source {split_source(index)};
+
+        return source != table_size && (signature(source) & bits) == bits;
+    } else {
+        return true;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::sign(size_type index, size_type key_hash) {
+    if constexpr (Traits::prefilter) signature(index) |= signature_bits(key_hash);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::rebuild_signature(size_type index) {
+    if constexpr (Traits::prefilter) {
+        const Bucket& current {bucket(index)};
+        size_type rebuilt {0};
+
+        current.for_each([&](const value_type& value, fingerprint_type fingerprint) {
+            rebuilt |= signature_bits(hash_at(value, fingerprint));
+        });
+
+        signature(index) = rebuilt;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::refresh_signatures() {
+    for (size_type i {0}; Traits::prefilter && i < active_table_size(); ++i) {
+        rebuild_signature(i);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::free_segment(size_type segment) {
+    release_prepared_segment();
+
+    if (segments[segment] != nullptr) {
+        for (size_type i {0}; i < segment_size(segment); ++i) {
+            segments[segment][i].~Bucket();
+        }
+
+        pool.template deallocate_bytes<segment_alignment>(reinterpret_cast<unsigned char*>(segments[segment]),
+                                                          segment_size(segment) * sizeof(Bucket));
+    }
+
+    if (occupancy[segment] != nullptr) pool.deallocate_array(occupancy[segment], bookkeeping_words(segment));
+
+    segments[segment] = nullptr;
+    occupancy[segment] = nullptr;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::bucket_index(size_type key_hash) const {
+    size_type index {h(key_hash)};
+
+    // Use next split round's hash function for already split buckets
+    if (index < table_split_index) {
+        index = g(key_hash);
+    }
+
+    return index;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::hash_at(const value_type& value, fingerprint_type fingerprint) const {
+    if constexpr (Traits::fingerprint == ADS_set_fingerprint::hash) {
+        return fingerprint;
+    } else {
+        return hash_of(value);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::reserve_buckets(size_type new_table_size) {
+    // Allocate one segment per doubling, the existing segments stay untouched
+    while (table_size < new_table_size) {
+        const size_type segment {segment_of(table_size)};
+        const size_type buckets {segment_size(segment)};
+
+        if constexpr (splits_incrementally) {
+            // The prepared segment is always the one of the next doubling
+            auto& prepared {this->split_progress().prepared};
+
+            prepare_segment(buckets);
+            segments[segment] = reinterpret_cast<Bucket*>(prepared.buckets);
+            occupancy[segment] = prepared.bookkeeping;
+            prepared = {};
+        } else {
+            // Start segments at a cache line, so buckets sized to lines don't straddle two of them
+            segments[segment] = reinterpret_cast<Bucket*>(
+                    pool.template allocate_bytes<segment_alignment>(buckets * sizeof(Bucket)));
+
+            for (size_type i {0}; i < buckets; ++i) {
+                new (segments[segment] + i) Bucket {};
+            }
+
+            occupancy[segment] = pool.template allocate_array<size_type>(bookkeeping_words(segment));
+            std::fill_n(occupancy[segment], bookkeeping_words(segment), 0);
+        }
+
+        table_size += segment_size(segment);
+        this->counters().add(ADS_set_event::doubling);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::prepare_segment(size_type count) {
+    if constexpr (splits_incrementally) {
+        auto& prepared {this->split_progress().prepared};
+        const size_type segment {segment_of(table_size)};
+        const size_type buckets {segment_size(segment)};
+
+        if (prepared.buckets == nullptr) {
+            // Start segments at a cache line, so buckets sized to lines don't straddle two of them
+            prepared.buckets = pool.template allocate_bytes<segment_alignment>(buckets * sizeof(Bucket));
+
+            try {
+                prepared.bookkeeping = pool.template allocate_array<size_type>(bookkeeping_words(segment));
+            } catch (...) {
+                pool.template deallocate_bytes<segment_alignment>(prepared.buckets, buckets * sizeof(Bucket));
+                prepared.buckets = nullptr;
+                throw;
+            }
+        }
+
+        for (const size_type end {std::min(buckets, prepared.count + count)}; prepared.count < end; ++prepared.count) {
+            const size_type offset {prepared.count};
+
+            new (prepared.buckets + offset * sizeof(Bucket)) Bucket {};
+
+            // Every bucket zeroes its signature, the first one of a bitmap word the whole word
+            if (offset % occupancy_word_bits == 0) prepared.bookkeeping[offset / occupancy_word_bits] = 0;
+            if constexpr (Traits::prefilter) prepared.bookkeeping[occupancy_words(segment) + offset] = 0;
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::release_prepared_segment() {
+    if constexpr (splits_incrementally) {
+        auto& prepared {this->split_progress().prepared};
+        const size_type segment {segment_of(table_size)};
+
+        if (prepared.buckets == nullptr) return;
+
+        for (size_type i {0}; i < prepared.count; ++i) {
+            reinterpret_cast<Bucket*>(prepared.buckets)[i].~Bucket();
+        }
+
+        pool.template deallocate_bytes<segment_alignment>(prepared.buckets, segment_size(segment) * sizeof(Bucket));
+        pool.deallocate_array(prepared.bookkeeping, bookkeeping_words(segment));
+        prepared = {};
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::split() {
+    // Calculate maximum table_size for this split round
+    const size_type max_table_size {size_type {1} << split_round};
+
+    // Double the table size
+    if (table_size == max_table_size) {
+        reserve_buckets(table_size << 1);
+    }
+
+    // Each value either stays or moves to the partner bucket of the next split round
+    const size_type split_index {table_split_index};
+    Bucket& split_bucket {bucket(split_index)};
+    Bucket& partner_bucket {bucket(split_index + max_table_size)};
+
+    // Both signatures are rebuilt from the hashes the split computes anyway
+    size_type signatures[2] {0, 0};
+
+    split_bucket.partition([&](const value_type& value, fingerprint_type fingerprint) {
+        const size_type key_hash {hash_at(value, fingerprint)};
+        const bool moves {g(key_hash) != split_index};
+
+        if constexpr (Traits::prefilter) signatures[moves] |= signature_bits(key_hash);
+
+        return moves;
+    }, partner_bucket, pool);
+
+    if constexpr (Traits::prefilter) {
+        signature(split_index) = signatures[0];
+        signature(split_index + max_table_size) = signatures[1];
+    }
+
+    update_occupancy(split_index + max_table_size);
+    this->counters().add(ADS_set_event::split);
+    this->counters().add(ADS_set_event::bytes_moved, partner_bucket.size() * sizeof(value_type));
+    update_occupancy(split_index);
+
+    if (++table_split_index == max_table_size) {
+        // Advance split round if all buckets have been split
+        table_split_index = 0;
+        ++split_round;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::merge() {
+    finish_splits();
+
+    // Never merge below the initial buckets
+    if (split_round == 1 && table_split_index == 0) return;
+
+    if (table_split_index == 0) {
+        // Free the segment of the split round that is walked back
+        if (table_size > (size_type {1} << split_round)) {
+            free_segment(split_round);
+            table_size >>= 1;
+        }
+
+        // Walk back to the previous split round
+        --split_round;
+        table_split_index = size_type {1} << split_round;
+    }
+
+    --table_split_index;
+
+    // Move values of partner bucket back to the bucket it was split from
+    Bucket& merge_bucket {bucket(table_split_index)};
+    Bucket& partner_bucket {bucket(table_split_index + (size_type {1} << split_round))};
+
+    partner_bucket.for_each([&](value_type& value, fingerprint_type fingerprint) {
+        merge_bucket.emplace_back(fingerprint, pool, std::move(value));
+    });
+
+    this->counters().add(ADS_set_event::bytes_moved, partner_bucket.size() * sizeof(value_type));
+
+    if constexpr (Traits::prefilter) {
+        signature(table_split_index) |= signature(table_split_index + (size_type {1} << split_round));
+        signature(table_split_index + (size_type {1} << split_round)) = 0;
+    }
+
+    // Release the partner bucket's values
+    partner_bucket.clear(pool);
+    update_occupancy(table_split_index);
+    update_occupancy(table_split_index + (size_type {1} << split_round));
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::start_split() {
+    const size_type max_table_size {size_type {1} << split_round};
+
+    // Double the table size, its segment has been prepared by the splits of the previous round
+    if (table_size == max_table_size) {
+        reserve_buckets(table_size << 1);
+    }
+
+    // Two buckets per split of this round prepare the segment of the next doubling
+    if (table_size == max_table_size << 1) prepare_segment(2);
+
+    auto& progress {this->split_progress()};
+    progress.active = true;
+    progress.from = table_split_index;
+    progress.to = table_split_index + max_table_size;
+    progress.cursor = 0;
+    progress.kept_signature = 0;
+
+    // Keys of the partner bucket select it right away, bucket_index() and split_source() find them
+    if (++table_split_index == max_table_size) {
+        table_split_index = 0;
+        ++split_round;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::queue_split() {
+    if (this->split_progress().active) {
+        ++this->split_progress().queued;
+    } else {
+        start_split();
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::advance_splits(size_type budget) {
+    auto& progress {this->split_progress()};
+
+    while (budget > 0) {
+        if (!progress.active) {
+            if (progress.queued == 0) return;
+
+            --progress.queued;
+            start_split();
+        }
+
+        Bucket& split_bucket {bucket(progress.from)};
+        Bucket& partner_bucket {bucket(progress.to)};
+        const size_type pending {split_bucket.size() - progress.cursor};
+        const size_type partner_size {partner_bucket.size()};
+
+        progress.cursor = split_bucket.partition_some([&](const value_type& value, fingerprint_type fingerprint) {
+            const size_type key_hash {hash_at(value, fingerprint)};
+            const bool moves {bucket_index(key_hash) != progress.from};
+
+            // The split bucket keeps its signature until all of its values are examined
+            if constexpr (Traits::prefilter) {
+                (moves ? signature(progress.to) : progress.kept_signature) |= signature_bits(key_hash);
+            }
+
+            return moves;
+        }, partner_bucket, pool, progress.cursor, budget);
+
+        // Every examined value either stayed before the cursor or left the bucket
+        budget -= std::min(budget, pending - (split_bucket.size() - progress.cursor));
+
+        if (partner_bucket.size() != partner_size) mark_occupied(progress.to);
+
+        this->counters().add(ADS_set_event::bytes_moved, (partner_bucket.size() - partner_size) * sizeof(value_type));
+        update_occupancy(progress.from);
+
+        if (progress.cursor == split_bucket.size()) {
+            if constexpr (Traits::prefilter) signature(progress.from) = progress.kept_signature;
+
+            progress.active = false;
+            this->counters().add(ADS_set_event::split);
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::finish_splits() {
+    if constexpr (splits_incrementally) {
+        while (this->split_progress().active || this->split_progress().queued > 0) {
+            advance_splits(std::numeric_limits<size_type>::max());
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::split_source(size_type index) const {
+    if constexpr (splits_incrementally) {
+        const auto& progress {this->split_progress()};
+
+        if (progress.active && index == progress.to) return progress.from;
+    }
+
+    return table_size;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K>
+std::pair<typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type, typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Position>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::locate_key(const K& key, size_type key_hash) const {
+    const size_type index {bucket_index(key_hash)};
+    const Bucket& current {bucket(index)};
+    const fingerprint_type fingerprint {fingerprint_of(key_hash)};
+    const Position found {current.index_of(key, fingerprint, equal)};
+
+    if constexpr (splits_incrementally) {
+        const size_type source {split_source(index)};
+
+        // The value might still wait in the bucket being split
+        if (found.index == current.size() && source != table_size) {
+            const Position moved {bucket(source).index_of(key, fingerprint, equal)};
+
+            if (moved.index != bucket(source).size()) return {source, moved};
+        }
+    }
+
+    return {index, found};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Layout ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::settled_layout() const {
+    if constexpr (splits_incrementally) {
+        const auto& progress {this->split_progress()};
+
+        // The partner bucket of the split in progress is the last bucket in use
+        if (progress.active) return {floor_log2(progress.to - progress.from), progress.from, active_table_size() - 1};
+    }
+
+    return {split_round, table_split_index, active_table_size()};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Visit>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::visit_settled(size_type index, Visit visit) const {
+    bucket(index).for_each(visit);
+
+    // The split bucket still holds the partner bucket's values in the settled layout
+    if constexpr (splits_incrementally) {
+        const auto& progress {this->split_progress()};
+
+        if (progress.active && index == progress.from) bucket(progress.to).for_each(visit);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::settled_size(size_type index) const {
+    if constexpr (splits_incrementally) {
+        const auto& progress {this->split_progress()};
+
+        if (progress.active && index == progress.from) return bucket(index).size() + bucket(progress.to).size();
+    }
+
+    return bucket(index).size();
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set() : ADS_set {hasher {}} {}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set(const allocator_type& allocator)
+        : ADS_set {hasher {}, key_equal {}, allocator} {}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set(const hasher& hash, const key_equal& equal,
+                                                            const allocator_type& allocator)
+        : split_round {1}, pool {allocator}, hash {hash}, equal {equal} {
+    segments = pool.template allocate_array<Bucket*>(max_segments);
+    std::fill_n(segments, max_segments, nullptr);
+    occupancy = pool.template allocate_array<size_type*>(max_segments);
+    std::fill_n(occupancy, max_segments, nullptr);
+    reserve_buckets(size_type {1} << split_round);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::~ADS_set() {
+    for (size_type segment {0}; segment < max_segments; ++segment) {
+        free_segment(segment);
+    }
+
+    pool.deallocate_array(segments, max_segments);
+    pool.deallocate_array(occupancy, max_segments);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename InputIt>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set(InputIt first, InputIt last): ADS_set {} {
+    insert(first, last);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename InputIt>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set(InputIt first, InputIt last, const allocator_type& allocator)
+        : ADS_set {allocator} {
+    insert(first, last);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set(std::initializer_list<key_type> ilist, const allocator_type& allocator)
+        : ADS_set {ilist.begin(), ilist.end(), allocator} {}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set(const ADS_set& other)
+        : ADS_set {other, std::allocator_traits<allocator_type>::select_on_container_copy_construction(other.get_allocator())} {}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set(const ADS_set& other, const allocator_type& allocator)
+        : ADS_set {other.hash, other.equal, allocator} {
+    // Clone the layout, so no value is hashed or split again
+    reserve_buckets(other.table_size);
+
+    for (size_type i {0}; i < other.active_table_size(); ++i) {
+        bucket(i).append(other.bucket(i), pool);
+    }
+
+    for (size_type segment {0}; segment < max_segments && other.segments[segment] != nullptr; ++segment) {
+        const size_type words {bookkeeping_words(segment)};
+        std::copy(other.occupancy[segment], other.occupancy[segment] + words, occupancy[segment]);
+    }
+
+    split_round = other.split_round;
+    table_split_index = other.table_split_index;
+    table_items_size = other.table_items_size;
+    first_occupied = other.first_occupied;
+
+    // The copy prepares its own segment of the next doubling
+    if constexpr (splits_incrementally) {
+        this->split_progress() = other.split_progress();
+        this->split_progress().prepared = {};
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set(ADS_set&& other) noexcept
+        : ADS_set {other.hash, other.equal, other.get_allocator()} {
+    swap_contents(other);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::ADS_set(ADS_set&& other, const allocator_type& allocator)
+        : ADS_set {other.hash, other.equal, allocator} {
+    // Memory of another allocator can't be taken over
+    if (get_allocator() == other.get_allocator()) {
+        swap_contents(other);
+    } else {
+        ADS_set copy {other, allocator};
+        swap_contents(copy);
+        other.clear();
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>& ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::operator=(const ADS_set& other) {
+    if (this == &other) return *this;
+
+    constexpr bool propagates {std::allocator_traits<allocator_type>::propagate_on_container_copy_assignment::value};
+
+    // The copy's allocator frees this set's old memory, so the allocators are swapped along with the contents
+    ADS_set copy {other, propagates ? other.get_allocator() : get_allocator()};
+    swap_contents(copy);
+
+    if constexpr (propagates) pool.swap_allocator(copy.pool);
+
+    return *this;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>& ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::operator=(ADS_set&& other) {
+    if (this == &other) return *this;
+
+    constexpr bool propagates {std::allocator_traits<allocator_type>::propagate_on_container_move_assignment::value};
+
+    if (propagates || get_allocator() == other.get_allocator()) {
+        ADS_set moved {std::move(other)};
+        swap_contents(moved);
+
+        if constexpr (propagates) pool.swap_allocator(moved.pool);
+    } else {
+        // Memory of another allocator can't be taken over, so the values are copied
+        ADS_set copy {other, get_allocator()};
+        swap_contents(copy);
+        other.clear();
+    }
+
+    return *this;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>& ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::operator=(std::initializer_list<key_type> ilist) {
+    ADS_set tmp {ilist, get_allocator()};
+    swap_contents(tmp);
+
+    return *this;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+std::pair<typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::iterator, bool> ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::insert(const ADS_set::key_type& key) {
+    return emplace_hashed(key, hash_of(key), key);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+std::pair<typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::iterator, bool> ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::insert(ADS_set::key_type&& key) {
+    // The key is only moved from once it is known to be new
+    return emplace_hashed(key, hash_of(key), std::move(key));
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename... Args>
+std::pair<typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::iterator, bool> ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::emplace(Args&&... args) {
+    // The key has to be constructed to be hashed, it is moved into the bucket afterwards
+    key_type key(std::forward<Args>(args)...);
+
+    return insert(std::move(key));
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K, typename... Args>
+std::pair<typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::iterator, bool>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::try_emplace(const K& key, Args&&... args) {
+    if constexpr (sizeof...(Args) == 0) {
+        return emplace_hashed(key, hash_of(key), key);
+    } else {
+        return emplace_hashed(key, hash_of(key), std::forward<Args>(args)...);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K, typename... Args>
+std::pair<typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator, bool>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::emplace_hashed(const K& key, size_type key_hash, Args&&... args) {
+    // Ignore insert if key already exists
+    const auto [found_index, found] {locate_key(key, key_hash)};
+
+    if (found.index != this->bucket(found_index).size()) {
+        return {Iterator {segments, occupancy, found_index, table_size, found.index, found.page}, false};
+    }
+
+    // Move values of pending splits only once the key is known to be new, its value might be one of them
+    if constexpr (splits_incrementally) advance_splits(Traits::split_budget);
+
+    // Reference bucket where key should be inserted
+    size_type insert_index {bucket_index(key_hash)};
+    Bucket* bucket {&this->bucket(insert_index)};
+    const fingerprint_type fingerprint {fingerprint_of(key_hash)};
+
+    // Split bucket if it's full
+    if (bucket->full()) {
+        if constexpr (splits_incrementally) {
+            queue_split();
+        } else {
+            split();
+        }
+
+        // Insert bucket might need an update after split
+        insert_index = bucket_index(key_hash);
+        bucket = &this->bucket(insert_index);
+    }
+
+    // Construct the value only now that it is known to be new
+    bucket->emplace_back(fingerprint, pool, std::forward<Args>(args)...);
+    mark_occupied(insert_index);
+    sign(insert_index, key_hash);
+    ++table_items_size;
+
+    return {Iterator {segments, occupancy, insert_index, table_size, bucket->size() - 1}, true};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename InputIt>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::insert(InputIt first, InputIt last) {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+        // Size the table for the whole range at once, duplicates only make it larger than needed
+        reserve(table_items_size + static_cast<size_type>(std::distance(first, last)));
+
+        size_type hashes[hash_batch_size];
+
+        while (first != last) {
+            // Hash a batch of keys and fetch their buckets before touching them
+            size_type batch_size {0};
+
+            for (auto it {first}; it != last && batch_size < hash_batch_size; ++it, ++batch_size) {
+                hashes[batch_size] = hash_of(*it);
+                __builtin_prefetch(&bucket(bucket_index(hashes[batch_size])));
+            }
+
+            for (size_type i {0}; i < batch_size; ++i, ++first) {
+                auto&& key {*first};
+
+                emplace_hashed(key, hashes[i], std::forward<decltype(key)>(key));
+            }
+        }
+    } else {
+        for (auto it {first}; it != last; ++it) {
+            insert(*it);
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::insert(std::initializer_list<key_type> ilist) {
+    insert(ilist.begin(), ilist.end());
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::clear() {
+    // Destroy the values in place, the buckets and the released overflow pages stay for reuse
+    if (table_items_size > 0) {
+        for (size_type index {first_occupied}; index < active_table_size();
+             index = next_occupied(occupancy, index + 1, active_table_size())) {
+            bucket(index).clear(pool);
+        }
+    }
+
+    for (size_type segment {0}; segment < max_segments && segments[segment] != nullptr; ++segment) {
+        std::fill_n(occupancy[segment], bookkeeping_words(segment), 0);
+    }
+
+    table_items_size = 0;
+    first_occupied = 0;
+
+    // Without values the layout is settled already
+    if constexpr (splits_incrementally) {
+        this->split_progress().active = false;
+        this->split_progress().queued = 0;
+    }
+
+    // Counts start over like those of a new set
+    ADS_set_counters<Traits::stats> set_counters {};
+    ADS_set_counters<Traits::stats> pool_counters {};
+    this->counters().swap(set_counters);
+    pool.counters().swap(pool_counters);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::aligned_bucket(size_type index, const ADS_set& other) const {
+    const size_type other_index {other.bucket_index(index)};
+
+    // Values of a bucket taking part in the other set's split in progress may be in either bucket
+    if constexpr (splits_incrementally) {
+        const auto& progress {other.split_progress()};
+
+        if (progress.active && (other_index == progress.from || other_index == progress.to)) return other.table_size;
+    }
+
+    return other.bucket_depth(other_index) <= bucket_depth(index) ? other_index : other.table_size;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+bool ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::exists_in(const value_type& value, fingerprint_type fingerprint,
+                                                       size_type aligned, const ADS_set& other) const {
+    // Both sets store the same fingerprints, only values of unaligned buckets need their hash
+    if (aligned == other.table_size) {
+        const auto [other_index, found] {other.locate_key(value, hash_at(value, fingerprint))};
+
+        return found.index != other.bucket(other_index).size();
+    }
+
+    const Bucket& other_bucket {other.bucket(aligned)};
+
+    return other_bucket.index_of(value, fingerprint, other.equal).index != other_bucket.size();
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::merge(ADS_set&& other) {
+    if (&other == this || other.table_items_size == 0) return;
+
+    // Fix the layout first, so the moved values never trigger a split
+    other.finish_splits();
+    reserve(table_items_size + other.table_items_size);
+
+    for (size_type i {0}; i < other.active_table_size(); ++i) {
+        Bucket& source {other.bucket(i)};
+        const size_type aligned {other.aligned_bucket(i, *this)};
+
+        // All values of an aligned bucket go to the same bucket, which takes over their signature
+        if constexpr (Traits::prefilter) {
+            if (aligned != table_size) signature(aligned) |= other.signature(i);
+        }
+
+        source.for_each([&](value_type& value, fingerprint_type fingerprint) {
+            size_type target_index {aligned};
+
+            if (aligned == table_size) {
+                const size_type key_hash {other.hash_at(value, fingerprint)};
+
+                target_index = bucket_index(key_hash);
+                fingerprint = fingerprint_of(key_hash);
+                sign(target_index, key_hash);
+            }
+
+            Bucket& target {bucket(target_index)};
+
+            if (target.index_of(value, fingerprint, equal).index == target.size()) {
+                target.emplace_back(fingerprint, pool, std::move(value));
+                mark_occupied(target_index);
+                ++table_items_size;
+            }
+        });
+    }
+
+    // The moved-from values are destroyed with the other set's buckets
+    other.clear();
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::retain(const ADS_set& other, bool keep_existing) {
+    // Removing values in place needs every value in its own bucket
+    finish_splits();
+
+    for (size_type i {0}; i < active_table_size(); ++i) {
+        Bucket& current {bucket(i)};
+        const size_type aligned {aligned_bucket(i, other)};
+
+        const size_type removed {current.remove_if([&](const value_type& value, fingerprint_type fingerprint) {
+            return exists_in(value, fingerprint, aligned, other) != keep_existing;
+        }, pool)};
+
+        table_items_size -= removed;
+        update_occupancy(i);
+
+        if (removed != 0) rebuild_signature(i);
+    }
+
+    merge_to_low_water();
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::merge_to_low_water() {
+    while (active_table_size() > 2 && table_items_size * low_water_divisor < active_table_size() * N) {
+        merge();
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename InputIt>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::erase(InputIt first, InputIt last) {
+    using category = typename std::iterator_traits<InputIt>::iterator_category;
+
+    size_type erased {0};
+
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+        size_type hashes[hash_batch_size];
+
+        while (first != last) {
+            // Hash a batch of keys and fetch their buckets before touching them
+            size_type batch_size {0};
+
+            for (auto it {first}; it != last && batch_size < hash_batch_size; ++it, ++batch_size) {
+                hashes[batch_size] = hash_of(*it);
+                bucket(bucket_index(hashes[batch_size])).prefetch();
+            }
+
+            // Merges of earlier erases only make a prefetched bucket useless, the index is computed again
+            for (size_type i {0}; i < batch_size; ++i, ++first) {
+                erased += erase_hashed(*first, hashes[i]);
+            }
+        }
+    } else {
+        for (auto it {first}; it != last; ++it) {
+            erased += erase_key(*it);
+        }
+    }
+
+    return erased;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Predicate>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::erase_if(Predicate predicate) {
+    // Compacting buckets reorders their values, which needs every value in its own bucket
+    finish_splits();
+
+    const size_type old_size {table_items_size};
+
+    for (size_type index {first_occupied}; table_items_size > 0 && index < active_table_size();
+         index = next_occupied(occupancy, index + 1, active_table_size())) {
+        Bucket& current {bucket(index)};
+        const size_type bucket_size {current.size()};
+
+        // Account for the values removed so far even if the predicate throws
+        const auto account = [&] {
+            table_items_size -= bucket_size - current.size();
+            update_occupancy(index);
+
+            if (current.size() != bucket_size) rebuild_signature(index);
+        };
+
+        try {
+            current.remove_if([&](const value_type& value, fingerprint_type) { return predicate(value); }, pool);
+        } catch (...) {
+            account();
+            throw;
+        }
+
+        account();
+    }
+
+    merge_to_low_water();
+
+    return old_size - table_items_size;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::intersect_with(const ADS_set& other) {
+    if (&other == this) return;
+
+    retain(other, true);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::difference_with(const ADS_set& other) {
+    if (&other == this) {
+        clear();
+        return;
+    }
+
+    retain(other, false);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::intersection_size(const ADS_set& other) const {
+    if (other.table_items_size < table_items_size) return other.intersection_size(*this);
+
+    size_type common {0};
+
+    for (size_type i {0}; i < active_table_size(); ++i) {
+        const Bucket& current {bucket(i)};
+        const size_type aligned {aligned_bucket(i, other)};
+
+        current.for_each([&](const value_type& value, fingerprint_type fingerprint) {
+            common += exists_in(value, fingerprint, aligned, other);
+        });
+    }
+
+    return common;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::reserve(size_type count) {
+    const size_type buckets {(count + N - 1) / N};
+
+    finish_splits();
+
+    if (buckets <= active_table_size()) return;
+
+    // Allocate all segments at once
+    reserve_buckets(buckets);
+
+    if (table_items_size == 0) {
+        // Without values there is nothing to redistribute, so jump to the final split state
+        split_round = floor_log2(buckets);
+        table_split_index = buckets - (size_type {1} << split_round);
+    } else {
+        while (active_table_size() < buckets) {
+            split();
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::shrink_to_fit() {
+    finish_splits();
+
+    // Merge buckets as long as the merged table is at most half full
+    while (active_table_size() > 2 && table_items_size * 2 <= (active_table_size() - 1) * N) {
+        merge();
+    }
+
+    // Free the segment that was reserved for the current split round but isn't used yet
+    if (table_split_index == 0 && table_size > (size_type {1} << split_round)) {
+        free_segment(split_round);
+        table_size >>= 1;
+    }
+
+    // Move overflow values into a fresh pool to release the memory of unused pages
+    if (pool.has_free_pages()) {
+        Pool relocated_pool {pool.get_allocator()};
+
+        for (size_type i {0}; i < table_size; ++i) {
+            bucket(i).relocate(relocated_pool);
+        }
+
+        pool.swap(relocated_pool);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+bool ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::maintenance(size_type budget) {
+    if constexpr (splits_incrementally) {
+        advance_splits(budget);
+
+        return this->split_progress().active || this->split_progress().queued > 0;
+    } else {
+        return false;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::erase_key(const K& key) {
+    return erase_hashed(key, hash_of(key));
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::erase_hashed(const K& key, size_type key_hash) {
+    if (!may_contain(key_hash)) return 0;
+
+    // Reference bucket where key's value is at
+    const auto [erase_index, found] {locate_key(key, key_hash)};
+    Bucket& bucket {this->bucket(erase_index)};
+
+    // Do not erase anything if value couldn't be found
+    if (found.index == bucket.size()) return 0;
+
+    bucket.remove_at(found.index, found.page, pool);
+    update_occupancy(erase_index);
+    --table_items_size;
+
+    // Signatures keep the bits of erased values, they are rebuilt once they hold too many stale bits. It takes a
+    // fifth of the bucket's values to be erased since the last rebuild, so erases hash a bounded amount of values
+    if constexpr (Traits::prefilter) {
+        if (bucket.size() == 0) {
+            signature(erase_index) = 0;
+        } else if (2 * static_cast<size_type>(__builtin_popcountll(signature(erase_index))) > 5 * bucket.size() + 4) {
+            rebuild_signature(erase_index);
+        }
+    }
+
+    if constexpr (splits_incrementally) {
+        auto& progress {this->split_progress()};
+
+        // The last value took the freed slot and has to be examined again
+        if (progress.active && erase_index == progress.from && found.index < progress.cursor) progress.cursor = found.index;
+    }
+
+    // Merge buckets if the load has fallen below the low-water mark
+    const bool below_low_water {table_items_size * low_water_divisor < active_table_size() * N};
+
+    if constexpr (splits_incrementally) {
+        auto& progress {this->split_progress()};
+
+        // Stay within the split budget: a queued split is dropped instead of merging, and merges wait for the split
+        // in progress, since merge() would finish it at once
+        if (below_low_water && progress.queued > 0) {
+            --progress.queued;
+        } else if (below_low_water && !progress.active) {
+            merge();
+        } else {
+            advance_splits(Traits::split_budget);
+        }
+    } else if (below_low_water) {
+        merge();
+    }
+
+    return 1;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::count_key(const K& key) const {
+    // Reference where value should be at
+    const size_type key_hash {hash_of(key)};
+
+    if (!may_contain(key_hash)) {
+        this->counters().add(ADS_set_event::miss);
+        this->counters().add(ADS_set_event::filtered_miss);
+
+        return 0;
+    }
+
+    if constexpr (Traits::stats || splits_incrementally) {
+        const auto [found_index, found] {locate_key(key, key_hash)};
+        count_lookup(this->bucket(found_index), found.index);
+
+        return found.index < this->bucket(found_index).size();
+    }
+
+    Bucket& bucket {this->bucket(bucket_index(key_hash))};
+
+    // Check if key could be found in bucket
+    return bucket.locate(key, fingerprint_of(key_hash), equal) != nullptr;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::iterator ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::find_key(const K& key) const {
+    const size_type key_hash {hash_of(key)};
+
+    if (!may_contain(key_hash)) {
+        this->counters().add(ADS_set_event::miss);
+        this->counters().add(ADS_set_event::filtered_miss);
+
+        return end();
+    }
+
+    // Check if value with key exists in the bucket where it should be at
+    const auto [find_index, found] {locate_key(key, key_hash)};
+    const Bucket* bucket {&this->bucket(find_index)};
+
+    count_lookup(*bucket, found.index);
+
+    // Return iterator to the found item
+    if (found.index < bucket->size()) {
+        return Iterator(segments, occupancy, find_index, table_size, found.index, found.page);
+    }
+
+    // If nothing was found return end iterator
+    return end();
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::parallel_ranges(const ADS_thread_pool& threads) const {
+    const size_type ranges {threads.size() * ranges_per_thread};
+
+    return ranges < active_table_size() ? ranges : active_table_size();
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Predicate>
+bool ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::parallel_all_of(Predicate predicate, ADS_thread_pool& threads) const {
+    const size_type ranges {parallel_ranges(threads)};
+    std::atomic<bool> failed {false};
+
+    threads.parallel_for(ranges, [&](size_type range) {
+        for (const auto& item: bucket_range(range_begin(range, ranges), range_begin(range + 1, ranges))) {
+            if (failed.load(std::memory_order_relaxed)) return;
+
+            if (!predicate(item)) {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    });
+
+    return !failed.load();
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+bool ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::contained_in(const ADS_set& other) const {
+    // Large sets are compared on all threads
+    if (table_items_size >= parallel_min_size) {
+        return parallel_all_of([&](const_reference item) { return other.count(item) != 0; },
+                               ADS_thread_pool::shared());
+    }
+
+    for (const auto& item: *this) {
+        if (!other.count(item)) return false;
+    }
+
+    return true;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Function>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::parallel_for_each(Function function, ADS_thread_pool& threads) const {
+    const size_type ranges {parallel_ranges(threads)};
+
+    threads.parallel_for(ranges, [&](size_type range) {
+        for (const auto& item: bucket_range(range_begin(range, ranges), range_begin(range + 1, ranges))) {
+            function(item);
+        }
+    });
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename RandomIt>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::parallel_insert(RandomIt first, RandomIt last, ADS_thread_pool& threads) {
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                          typename std::iterator_traits<RandomIt>::iterator_category>,
+                  "parallel_insert requires random access iterators");
+
+    const auto count {static_cast<size_type>(last - first)};
+
+    if (count < parallel_min_size || threads.size() == 1) {
+        insert(first, last);
+        return;
+    }
+
+    // Fix the final layout, so the buckets can be filled independently of each other
+    reserve(table_items_size + count);
+
+    const size_type ranges {parallel_ranges(threads)};
+    const size_type chunks {(count + parallel_chunk_size - 1) / parallel_chunk_size};
+    const auto range_of = [&](size_type key_hash) { return bucket_index(key_hash) * ranges / active_table_size(); };
+
+    // Hashes and key order per range, followed by the positions of every chunk's keys per range
+    // and the amount of keys inserted per range, taken from the set's allocator like all of its memory
+    const size_type scratch_size {2 * count + chunks * ranges + ranges};
+    size_type* scratch {pool.template allocate_array<size_type>(scratch_size)};
+    std::fill_n(scratch, scratch_size, 0);
+    size_type* hashes {scratch};
+    size_type* order {hashes + count};
+    size_type* positions {order + count};
+    size_type* inserted {positions + chunks * ranges};
+    Pool* pools {nullptr};
+
+    const auto release_pools = [&] {
+        for (size_type range {0}; pools != nullptr && range < ranges; ++range) {
+            pools[range].~Pool();
+        }
+
+        if (pools != nullptr) pool.deallocate_array(pools, ranges);
+        pool.deallocate_array(scratch, scratch_size);
+    };
+
+    try {
+        threads.parallel_for(chunks, [&](size_type chunk) {
+            const size_type end {std::min((chunk + 1) * parallel_chunk_size, count)};
+
+            for (size_type i {chunk * parallel_chunk_size}; i < end; ++i) {
+                hashes[i] = hash_of(first[static_cast<difference_type>(i)]);
+                ++positions[chunk * ranges + range_of(hashes[i])];
+            }
+        });
+
+        // Turn the counts into positions, keys are grouped by range and ordered by chunk within a range
+        size_type position {0};
+
+        for (size_type range {0}; range < ranges; ++range) {
+            for (size_type chunk {0}; chunk < chunks; ++chunk) {
+                const size_type keys {positions[chunk * ranges + range]};
+                positions[chunk * ranges + range] = position;
+                position += keys;
+            }
+        }
+
+        threads.parallel_for(chunks, [&](size_type chunk) {
+            const size_type end {std::min((chunk + 1) * parallel_chunk_size, count)};
+
+            for (size_type i {chunk * parallel_chunk_size}; i < end; ++i) {
+                order[positions[chunk * ranges + range_of(hashes[i])]++] = i;
+            }
+        });
+
+        // Every range takes overflow pages from its own pool, they are merged into the set's pool afterwards
+        pools = pool.template allocate_array<Pool>(ranges);
+
+        for (size_type range {0}; range < ranges; ++range) {
+            new (pools + range) Pool {pool.get_allocator()};
+        }
+
+        threads.parallel_for(ranges, [&](size_type range) {
+            // The last chunk's positions now mark the end of every range's keys
+            const size_type begin {range == 0 ? 0 : positions[(chunks - 1) * ranges + range - 1]};
+            const size_type end {positions[(chunks - 1) * ranges + range]};
+
+            for (size_type k {begin}; k < end; ++k) {
+                const size_type i {order[k]};
+                const auto& key {first[static_cast<difference_type>(i)]};
+                const size_type index {bucket_index(hashes[i])};
+                Bucket& bucket {this->bucket(index)};
+                const fingerprint_type fingerprint {fingerprint_of(hashes[i])};
+
+                if (bucket.index_of(key, fingerprint, equal).index == bucket.size()) {
+                    bucket.emplace_back(fingerprint, pools[range], key);
+
+                    // Every bucket belongs to one range, so its signature is only written by one thread
+                    sign(index, hashes[i]);
+                    ++inserted[range];
+                }
+            }
+        });
+    } catch (...) {
+        // Keep the values inserted before the failure
+        for (size_type range {0}; pools != nullptr && range < ranges; ++range) {
+            pool.adopt(pools[range]);
+            table_items_size += inserted[range];
+        }
+
+        refresh_occupancy();
+        release_pools();
+        throw;
+    }
+
+    for (size_type range {0}; range < ranges; ++range) {
+        pool.adopt(pools[range]);
+        table_items_size += inserted[range];
+    }
+
+    // The ranges share bitmap words at their borders, so the bits are set once all ranges are done
+    refresh_occupancy();
+    release_pools();
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Visit>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::probe_batch(const key_type* keys, size_type count, Visit visit) const {
+    constexpr size_type stages {3};
+
+    // Hashes and bucket indices of the groups in flight
+    size_type hashes[stages][probe_group_size];
+    size_type indices[stages][probe_group_size];
+    const size_type groups {(count + probe_group_size - 1) / probe_group_size};
+
+    for (size_type step {0}; step < groups + stages - 1; ++step) {
+        // Hash the newest group and fetch its buckets
+        if (step < groups) {
+            const size_type begin {step * probe_group_size};
+            const size_type end {std::min(begin + probe_group_size, count)};
+
+            for (size_type i {begin}; i < end; ++i) {
+                hashes[step % stages][i - begin] = hash_of(keys[i]);
+                indices[step % stages][i - begin] = bucket_index(hashes[step % stages][i - begin]);
+                bucket(indices[step % stages][i - begin]).prefetch();
+            }
+        }
+
+        // Fetch the overflow pages of the previous group, whose buckets should have arrived by now
+        if (step >= 1 && step - 1 < groups) {
+            const size_type group {step - 1};
+            const size_type begin {group * probe_group_size};
+            const size_type end {std::min(begin + probe_group_size, count)};
+
+            for (size_type i {begin}; i < end; ++i) {
+                bucket(indices[group % stages][i - begin]).prefetch_overflow();
+            }
+        }
+
+        // Compare the keys of the oldest group
+        if (step >= stages - 1) {
+            const size_type group {step - (stages - 1)};
+            const size_type begin {group * probe_group_size};
+            const size_type end {std::min(begin + probe_group_size, count)};
+
+            for (size_type i {begin}; i < end; ++i) {
+                size_type index {indices[group % stages][i - begin]};
+                const fingerprint_type fingerprint {fingerprint_of(hashes[group % stages][i - begin])};
+
+                Position found {bucket(index).index_of(keys[i], fingerprint, equal)};
+
+                // Misses in the partner bucket of a split in progress look again in the split bucket
+                if constexpr (splits_incrementally) {
+                    if (found.index == bucket(index).size() && split_source(index) != table_size) {
+                        std::tie(index, found) = locate_key(keys[i], hashes[group % stages][i - begin]);
+                    }
+                }
+
+                count_lookup(bucket(index), found.index);
+                visit(i, index, found);
+            }
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::count_batch(const key_type* keys, size_type count, size_type* counts) const {
+    probe_batch(keys, count, [&](size_type i, size_type bucket_index, Position position) {
+        counts[i] = position.index != bucket(bucket_index).size();
+    });
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::find_batch(const key_type* keys, size_type count, iterator* found) const {
+    probe_batch(keys, count, [&](size_type i, size_type bucket_index, Position position) {
+        found[i] = position.index != bucket(bucket_index).size() ?
+                   Iterator {segments, occupancy, bucket_index, table_size, position.index, position.page} : end();
+    });
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::contains_many(const key_type* keys, size_type count, size_type* bits) const {
+    constexpr size_type word_bits {sizeof(size_type) * CHAR_BIT};
+
+    for (size_type word {0}; word < (count + word_bits - 1) / word_bits; ++word) {
+        bits[word] = 0;
+    }
+
+    probe_batch(keys, count, [&](size_type i, size_type bucket_index, Position position) {
+        if (position.index != bucket(bucket_index).size()) bits[i / word_bits] |= size_type {1} << (i % word_bits);
+    });
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::swap(ADS_set& other) {
+    swap_contents(other);
+
+    if constexpr (std::allocator_traits<allocator_type>::propagate_on_container_swap::value) {
+        pool.swap_allocator(other.pool);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::swap_contents(ADS_set& other) {
+    using std::swap;
+
+    swap(split_round, other.split_round);
+    swap(table_split_index, other.table_split_index);
+    swap(table_size, other.table_size);
+    swap(table_items_size, other.table_items_size);
+    swap(segments, other.segments);
+    swap(occupancy, other.occupancy);
+    swap(first_occupied, other.first_occupied);
+    pool.swap(other.pool);
+    this->counters().swap(other.counters());
+    swap(this->split_progress(), other.split_progress());
+    swap(hash, other.hash);
+    swap(equal, other.equal);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::const_iterator ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::begin() const {
+    if (table_items_size == 0) return end();
+
+    return Iterator {segments, occupancy, first_occupied, table_size, 0};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::const_iterator ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::end() const {
+    return Iterator {segments, occupancy, table_size, table_size, 0};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::dump(std::ostream& o) const {
+    o << "split_round = " << split_round;
+    o << ", table_split_index = " << table_split_index;
+    o << ", table_size = " << table_size;
+    o << ", table_items_size = " << table_items_size;
+    o << "\n\n";
+
+    for (size_type i {0}; i < table_size; ++i) {
+        o << (table_split_index == i ? "-> " : "   ");
+        o << std::setfill(' ') << std::setw(4) << i << " | ";
+        bucket(i).dump(o);
+        o << "\n";
+    }
+
+    o << "\n";
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::count_lookup(const Bucket& bucket, size_type index) const {
+    if constexpr (Traits::stats) {
+        // A hit examined the values up to the found one, a miss all values of the bucket
+        if (index < bucket.size()) {
+            this->counters().add(ADS_set_event::hit);
+            this->counters().add(ADS_set_event::hit_probe, index + 1);
+        } else {
+            this->counters().add(ADS_set_event::miss);
+            this->counters().add(ADS_set_event::miss_probe, bucket.size());
+        }
+    }
+}
 
-    /**
-     * Get the index of a stored key's value in the bucket.
-     *
-     * @param key the key to find
-     * @return Index of the found element; if it wasn't found the size of the bucket
-     */
-    size_type index_of(const key_type& key) const;
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set_stats ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::stats() const {
+    ADS_set_stats result {};
+
+    result.splits = this->counters().get(ADS_set_event::split);
+    result.doublings = this->counters().get(ADS_set_event::doubling);
+    result.bytes_moved = this->counters().get(ADS_set_event::bytes_moved);
+    result.expansions = pool.counters().get(ADS_set_event::expansion);
+    result.hits = this->counters().get(ADS_set_event::hit);
+    result.misses = this->counters().get(ADS_set_event::miss);
+    result.hit_probes = this->counters().get(ADS_set_event::hit_probe);
+    result.miss_probes = this->counters().get(ADS_set_event::miss_probe);
+    result.filtered_misses = this->counters().get(ADS_set_event::filtered_miss);
+    result.buckets = active_table_size();
+
+    for (size_type i {0}; i < active_table_size(); ++i) {
+        const size_type length {bucket(i).page_count()};
+
+        result.overflow_pages += length;
+        result.overflow_buckets += length != 0;
+        result.max_chain_length = std::max(result.max_chain_length, length);
+        ++result.chain_histogram[std::min(length, ADS_set_stats::histogram_size - 1)];
+    }
 
-    /**
-     * Locate the value stored with the given key.
-     *
-     * @param key the key to locate for
-     * @return pointer to found value; if nothing was found nullptr
-     */
-    value_type* locate(const key_type& key) const;
+    result.mean_chain_length = static_cast<double>(result.overflow_pages) / static_cast<double>(result.buckets);
+    result.load_factor = static_cast<double>(table_items_size) / static_cast<double>(result.buckets);
 
-    /**
-     * Push a key to the bucket.
-     *
-     * @param key the key to insert
-     * @return the index where the key was added at.
-     */
-    std::pair<size_type, bool> insert(key_type key);
+    return result;
+}
 
-    /**
-     * Count how many times a key exists in the bucket (0 or 1 times):
-     *
-     * @param key the key to count for
-     * @return how many times the key exists (0 or 1)
-     */
-    size_type count(const key_type& key) const;
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::save(const std::string& path) const {
+    static_assert(std::is_trivially_copyable_v<key_type> || ADS_set_is_string<key_type>::value,
+                  "save requires trivially copyable or string keys");
 
-    /**
-     * Remove item with key from the bucket.
-     *
-     * @param key they key to remove
-     * @return how many items were removed (0 or 1)
-     */
-    size_type erase(const key_type& key);
+    std::ofstream file {path, std::ios::binary | std::ios::trunc};
+    ADS_set_file_header header {};
+    const char padding[8] {};
+    size_type position {0};
 
-    /**
-     * Swap this bucket with the given other bucket.
-     *
-     * @param other the bucket to swap with
-     */
-    void swap(Bucket& other);
+    // Write bytes behind the header, keeping track of their checksum and position
+    const auto write = [&](const void* data, size_type bytes) {
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        header.checksum = ADS_set_file_header::checksum_of(header.checksum, data, bytes);
+        position += bytes;
+    };
 
-    /**
-     * Get the amount of stored values.
-     *
-     * @return amount of stored values
-     */
-    [[nodiscard]] size_type size() const { return values_size; }
+    std::copy(ADS_set_file_header::file_magic, ADS_set_file_header::file_magic + 8, header.magic);
+    header.version = ADS_set_file_header::file_version;
+    header.mixer = static_cast<std::uint32_t>(Traits::mixer);
+    header.hash_size = sizeof(size_type);
+    // A split in progress isn't written, the file holds the layout before it
+    const Layout layout {settled_layout()};
 
-    /**
-     * Get the amount of available values.
-     *
-     * @return amount of available values
-     */
-    [[nodiscard]] size_type capacity() const { return values_capacity; }
+    header.split_round = layout.split_round;
+    header.table_split_index = layout.split_index;
+    header.bucket_count = layout.buckets;
+    header.items_size = table_items_size;
+    header.checksum = ADS_set_file_header::checksum_seed;
 
-    /**
-     * Get whether the bucket is full.
-     *
-     * @return if bucket is full
-     */
-    [[nodiscard]] size_type full() const { return values_size == values_capacity; }
+    // The real header is written once the checksum is known
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
-    /**
-     * Dump the bucket's content to a given stream.
-     *
-     * @param o the stream to dump to
-     */
-    void dump(std::ostream& o = std::cerr) const;
-};
+    std::uint64_t offset {0};
 
-template<typename Key, size_t N>
-class ADS_set<Key, N>::Iterator {
-public:
-    using value_type = Key;
-    using difference_type = std::ptrdiff_t;
-    using reference = const value_type&;
-    using pointer = const value_type*;
-    using iterator_category = std::forward_iterator_tag;
-private:
-    using bucket_pointer = typename ADS_set<Key, N>::Bucket*;
-    using bucket_size_type = typename ADS_set<Key, N>::size_type;
+    if constexpr (ADS_set_is_string<key_type>::value) {
+        using char_type = typename key_type::value_type;
 
-    /** Pointer to current bucket */
-    bucket_pointer current {nullptr};
+        header.strings = 1;
+        header.key_size = sizeof(char_type);
 
-    /** Pointer to end bucket */
-    bucket_pointer end {nullptr};
+        // Every record is 8-byte aligned, the offsets count bytes
+        const auto record_size = [](const key_type& key) {
+            return (2 * sizeof(std::uint64_t) + key.size() * sizeof(char_type) + 7) / 8 * 8;
+        };
 
-    /** Index of current value in current bucket */
-    bucket_size_type index {0};
+        for (size_type i {0}; i < layout.buckets; ++i) {
+            write(&offset, sizeof(offset));
 
-    /**
-     * Advance current bucket until bucket has values or is at end bucket.
-     */
-    void skip_empty_buckets();
+            visit_settled(i, [&](const value_type& key, fingerprint_type) { offset += record_size(key); });
+        }
 
-public:
-    /**
-     * Default constructor
-     */
-    Iterator() = default;
+        write(&offset, sizeof(offset));
 
-    /**
-     * Creates iterator with current and end bucket and index to current value.
-     *
-     * @param current pointer to current bucket
-     * @param end pointer to end bucket
-     * @param index index to current value in current bucket
-     */
-    explicit Iterator(bucket_pointer current, bucket_pointer end, bucket_size_type index);
+        for (size_type i {0}; i < layout.buckets; ++i) {
+            visit_settled(i, [&](const value_type& key, fingerprint_type fingerprint) {
+                const std::uint64_t record[2] {hash_at(key, fingerprint), key.size()};
+                const size_type characters {key.size() * sizeof(char_type)};
 
-    reference operator*() const;
+                write(record, sizeof(record));
+                write(key.data(), characters);
+                write(padding, record_size(key) - sizeof(record) - characters);
+            });
+        }
+    } else {
+        constexpr size_type alignment {alignof(key_type) > 8 ? alignof(key_type) : 8};
 
-    pointer operator->() const;
+        header.strings = 0;
+        header.key_size = sizeof(key_type);
 
-    Iterator& operator++();
+        for (size_type i {0}; i < layout.buckets; ++i) {
+            write(&offset, sizeof(offset));
+            offset += settled_size(i);
+        }
 
-    Iterator operator++(int);
+        write(&offset, sizeof(offset));
 
-    friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
-        return lhs.current == rhs.current && lhs.end == rhs.end &&
-               lhs.index == rhs.index;
-    }
+        // Align the values relative to the start of the file, mappings start at page boundaries
+        for (size_type pad {(alignment - (sizeof(header) + position) % alignment) % alignment}; pad > 0;) {
+            const size_type bytes {pad < sizeof(padding) ? pad : sizeof(padding)};
+            write(padding, bytes);
+            pad -= bytes;
+        }
 
-    friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
-        return !(lhs == rhs);
+        for (size_type i {0}; i < layout.buckets; ++i) {
+            visit_settled(i, [&](const value_type& key, fingerprint_type) { write(&key, sizeof(key_type)); });
+        }
     }
-};
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::Bucket& ADS_set<Key, N>::bucket_at(const key_type& key) const {
-    size_type index {h(key)};
+    header.body_size = position;
+    header.checksum = header.file_checksum(header.checksum);
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
 
-    // Use next split round's hash function for already split buckets
-    if (index < table_split_index) {
-        index = g(key);
+    if (!file) throw std::runtime_error {"ADS_set: can't write " + path};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::write(std::ostream& stream) const {
+    ADS_set_writer writer {stream};
+
+    // A split in progress isn't written, the stream holds the layout before it
+    const Layout settled {settled_layout()};
+    const std::uint64_t layout[8] {ADS_set_file_header::file_version, static_cast<std::uint64_t>(Traits::fingerprint),
+                                   static_cast<std::uint64_t>(Traits::mixer), sizeof(size_type),
+                                   settled.split_round, settled.split_index, settled.buckets, table_items_size};
+
+    writer.write(layout, sizeof(layout));
+
+    for (size_type i {0}; i < settled.buckets; ++i) {
+        const std::uint64_t values {settled_size(i)};
+
+        writer.write(&values, sizeof(values));
+
+        visit_settled(i, [&](const value_type& key, fingerprint_type fingerprint) {
+            if constexpr (has_fingerprints) writer.write(&fingerprint, sizeof(fingerprint));
+
+            ADS_set_serializer<key_type>::write(writer, key);
+        });
     }
 
-    return table[index];
+    writer.finish();
 }
 
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::read(std::istream& stream) {
+    ADS_set_reader reader {stream};
+    std::uint64_t layout[8];
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::reserve(size_type new_table_size) {
-    // Ignore calls that request making the table smaller
-    if (table_size >= new_table_size) return;
+    reader.read(layout, sizeof(layout));
 
-    // Reserve memory for the new_table's buckets
-    Bucket* new_table {new Bucket[new_table_size]};
+    // The fingerprints and the buckets of the values depend on the fingerprint kind and the finalizer
+    const bool valid {layout[0] == ADS_set_file_header::file_version &&
+                      layout[1] == static_cast<std::uint64_t>(Traits::fingerprint) &&
+                      layout[2] == static_cast<std::uint64_t>(Traits::mixer) && layout[3] == sizeof(size_type) &&
+                      layout[4] >= 1 && layout[4] < max_segments - 1 && layout[5] < (std::uint64_t {1} << layout[4]) &&
+                      layout[6] == (std::uint64_t {1} << layout[4]) + layout[5]};
 
-    // Copy current table content to new_table
-    for (size_type i {0}; i < table_size; ++i) {
-        new_table[i] = std::move(table[i]);
-    }
+    if (!valid) throw std::runtime_error {"ADS_set: stream holds no set of this type"};
 
-    delete[] table;
+    // Rebuild the layout in a new set, so a failure leaves this set untouched
+    ADS_set loaded {hash, equal, get_allocator()};
+    loaded.reserve_buckets(static_cast<size_type>(layout[6]));
+    loaded.split_round = static_cast<size_type>(layout[4]);
+    loaded.table_split_index = static_cast<size_type>(layout[5]);
 
-    // Update table to new_table
-    table = std::move(new_table);
-    table_size = new_table_size;
-}
+    for (size_type i {0}; i < loaded.active_table_size(); ++i) {
+        Bucket& current {loaded.bucket(i)};
+        std::uint64_t values;
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::split() {
-    // Calculate maximum table_size for this split round
-    const size_type max_table_size {1u << split_round};
+        reader.read(&values, sizeof(values));
 
-    // Double the table size
-    if (table_size == max_table_size) {
-        reserve(table_size << 1);
-    }
+        if (values > layout[7] - loaded.table_items_size) throw std::runtime_error {"ADS_set: malformed set"};
 
-    // Remove values from bucket to be split by moving bucket
-    Bucket bucket {std::move(table[table_split_index])};
+        for (std::uint64_t k {0}; k < values; ++k) {
+            fingerprint_type fingerprint {};
 
-    // Decrement the total items size by what has been removed by the bucket move
-    table_items_size -= bucket.size();
+            if constexpr (has_fingerprints) {
+                reader.read(&fingerprint, sizeof(fingerprint));
+            }
 
-    if (table_split_index >= max_table_size) {
-        // Advance split round if all buckets have been split
-        table_split_index = 0;
-        ++split_round;
-    } else {
-        // Else just advance split index
-        ++table_split_index;
+            current.emplace_back(fingerprint, loaded.pool, ADS_set_serializer<key_type>::read(reader));
+            ++loaded.table_items_size;
+        }
     }
 
-    // Add removed values back to set
-    for (size_type i {0}; i < bucket.size(); ++i) {
-        insert(bucket[i]);
-    }
+    if (loaded.table_items_size != layout[7]) throw std::runtime_error {"ADS_set: malformed set"};
+
+    reader.finish();
+    loaded.refresh_occupancy();
+    loaded.refresh_signatures();
+    swap_contents(loaded);
 }
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::ADS_set() : split_round {1}, table_size {1u << split_round}, table {new Bucket[table_size]} {}
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Page::bytes(size_type capacity) {
+    constexpr size_type alignment {alignof(value_type) > alignof(Page) ? alignof(value_type) : alignof(Page)};
+    constexpr size_type values_offset {(sizeof(Page) + alignment - 1) / alignment * alignment};
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::~ADS_set() {
-    delete[] table;
+    const size_type values_bytes {has_fingerprints ? fingerprints_offset(capacity) +
+                                                     fingerprints_size(capacity) * sizeof(fingerprint_type)
+                                                   : capacity * sizeof(value_type)};
+
+    return values_offset + values_bytes;
 }
 
-template<typename Key, size_t N>
-template<typename InputIt>
-ADS_set<Key, N>::ADS_set(InputIt first, InputIt last): ADS_set {} {
-    insert(first, last);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void* ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Page::raw(size_type index) {
+    constexpr size_type alignment {alignof(value_type) > alignof(Page) ? alignof(value_type) : alignof(Page)};
+    constexpr size_type values_offset {(sizeof(Page) + alignment - 1) / alignment * alignment};
+
+    return reinterpret_cast<unsigned char*>(this) + values_offset + index * sizeof(value_type);
 }
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::ADS_set(std::initializer_list<key_type> ilist) : ADS_set {ilist.begin(), ilist.end()} {}
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool::~Pool() {
+    while (chunks != nullptr) {
+        Chunk* next {chunks->next};
+        deallocate_bytes<alignment>(reinterpret_cast<unsigned char*>(chunks), chunks->bytes);
+        chunks = next;
+    }
+}
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::ADS_set(const ADS_set& other) : ADS_set {other.begin(), other.end()} {}
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename T>
+T* ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool::allocate_array(size_type count) {
+    rebound_allocator<T> rebound {this->allocator()};
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::ADS_set(ADS_set&& other) noexcept: ADS_set {} {
-    swap(other);
+    return std::allocator_traits<rebound_allocator<T>>::allocate(rebound, count);
 }
 
-template<typename Key, size_t N>
-ADS_set<Key, N>& ADS_set<Key, N>::operator=(ADS_set other) {
-    swap(other);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename T>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool::deallocate_array(T* array, size_type count) {
+    rebound_allocator<T> rebound {this->allocator()};
 
-    return *this;
+    std::allocator_traits<rebound_allocator<T>>::deallocate(rebound, array, count);
 }
 
-template<typename Key, size_t N>
-ADS_set<Key, N>& ADS_set<Key, N>::operator=(std::initializer_list<key_type> ilist) {
-    ADS_set tmp {ilist};
-    swap(tmp);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+unsigned char* ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool::allocate_chunk(size_type bytes) {
+    constexpr size_type header_bytes {(sizeof(Chunk) + alignment - 1) / alignment * alignment};
 
-    return *this;
+    unsigned char* memory {allocate_bytes<alignment>(header_bytes + bytes)};
+    chunks = new (memory) Chunk {chunks, header_bytes + bytes};
+
+    return static_cast<unsigned char*>(memory) + header_bytes;
 }
 
-template<typename Key, size_t N>
-std::pair<typename ADS_set<Key, N>::iterator, bool> ADS_set<Key, N>::insert(const ADS_set::key_type& key) {
-    // Reference bucket where key should be inserted
-    Bucket* bucket {&bucket_at(key)};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Page* ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool::allocate(size_type page_class) {
+    // Reuse released pages first
+    if (free_pages[page_class] != nullptr) {
+        Page* page {free_pages[page_class]};
+        free_pages[page_class] = page->next;
 
-    // Split bucket if it's full
-    if (bucket->full()) {
-        split();
+        return new (page) Page {};
+    }
 
-        // Insert bucket might need an update after split
-        bucket = &bucket_at(key);
+    // Larger pages are allocated one at a time
+    if (page_class > 0) {
+        return new (allocate_chunk(page_bytes(page_class))) Page {};
     }
 
-    // Try to insert key in bucket
-    auto [index, added] = bucket->insert(key);
+    // Allocate a new chunk if the most recent one is used up
+    if (chunk_left == 0) {
+        chunk_free = allocate_chunk(chunk_pages * page_bytes(0));
+        chunk_left = chunk_pages;
+    }
 
-    // Increment items size if value was added
-    if (added) ++table_items_size;
+    Page* page {new (chunk_free) Page {}};
+    chunk_free += page_bytes(0);
+    --chunk_left;
 
-    Iterator it {bucket, table + table_size, index};
+    return page;
+}
 
-    return {it, added};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool::release(Page* page, size_type page_class) {
+    page->next = free_pages[page_class];
+    free_pages[page_class] = page;
 }
 
-template<typename Key, size_t N>
-template<typename InputIt>
-void ADS_set<Key, N>::insert(InputIt first, InputIt last) {
-    for (auto it {first}; it != last; ++it) {
-        insert(*it);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+bool ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool::has_free_pages() const {
+    if (chunk_left > 0) return true;
+
+    for (size_type page_class {0}; page_class < page_classes; ++page_class) {
+        if (free_pages[page_class] != nullptr) return true;
     }
-}
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::insert(std::initializer_list<key_type> ilist) {
-    insert(ilist.begin(), ilist.end());
+    return false;
 }
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::clear() {
-    // Clear all values by creating new empty set and swap them
-    ADS_set tmp;
-    swap(tmp);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool::swap(Pool& other) {
+    using std::swap;
+
+    swap(chunks, other.chunks);
+    swap(chunk_free, other.chunk_free);
+    swap(chunk_left, other.chunk_left);
+    swap(free_pages, other.free_pages);
+    this->counters().swap(other.counters());
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::size_type ADS_set<Key, N>::erase(const ADS_set::key_type& key) {
-    // Reference bucket where key's value should be at
-    Bucket& bucket {bucket_at(key)};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Pool::adopt(Pool& other) {
+    this->counters().add(other.counters());
 
-    // Try to erase value from bucket
-    size_type erased {bucket.erase(key)};
+    if (other.chunks == nullptr) return;
 
-    // Decrement amount of items by how much was erased
-    table_items_size -= erased;
+    // Hand the unused pages of the other pool's newest chunk out as released pages
+    for (; other.chunk_left > 0; --other.chunk_left, other.chunk_free += page_bytes(0)) {
+        release(reinterpret_cast<Page*>(other.chunk_free), 0);
+    }
 
-    return erased;
-}
+    for (size_type page_class {0}; page_class < page_classes; ++page_class) {
+        while (other.free_pages[page_class] != nullptr) {
+            Page* page {other.free_pages[page_class]};
+            other.free_pages[page_class] = page->next;
+            release(page, page_class);
+        }
+    }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::size_type ADS_set<Key, N>::count(const key_type& key) const {
-    // Reference where value should be at
-    Bucket& bucket {bucket_at(key)};
+    // Chain the other pool's chunks in front of this pool's chunks
+    Chunk* last {other.chunks};
 
-    // Check if key could be found in bucket
-    return bucket.locate(key) != nullptr;
+    while (last->next != nullptr) {
+        last = last->next;
+    }
+
+    last->next = chunks;
+    chunks = other.chunks;
+    other.chunks = nullptr;
+    other.chunk_free = nullptr;
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::iterator ADS_set<Key, N>::find(const key_type& key) const {
-    // Reference bucket where key's value should be at
-    Bucket* bucket {&bucket_at(key)};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::~Bucket() {
+    for_each([](value_type& value, fingerprint_type) { value.~value_type(); });
+}
 
-    // Check if value with key exists in bucket
-    size_type index {bucket->index_of(key)};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::Bucket(Bucket&& other) noexcept: Fingerprints {other}, values_size {other.values_size},
+                                                                  overflow {other.overflow} {
+    const size_type inline_size {values_size < N ? values_size : N};
 
-    // Return iterator to the found item
-    if (index < bucket->capacity()) {
-        return Iterator(bucket, table + table_size, index);
+    // Move inline values, the overflow pages are taken over as they are
+    for (size_type i {0}; i < inline_size; ++i) {
+        new (values.raw(i)) value_type(std::move(other.values[i]));
+        other.values[i].~value_type();
     }
 
-    // If nothing was found return end iterator
-    return end();
+    other.values_size = 0;
+    other.overflow = nullptr;
 }
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::swap(ADS_set& other) {
-    using std::swap;
-
-    swap(split_round, other.split_round);
-    swap(table_split_index, other.table_split_index);
-    swap(table_size, other.table_size);
-    swap(table_items_size, other.table_items_size);
-    swap(table, other.table);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::page_number(size_type index) {
+    if constexpr (Traits::overflow == ADS_set_overflow::geometric) {
+        return floor_log2(index / N);
+    } else {
+        return index / N - 1;
+    }
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::const_iterator ADS_set<Key, N>::begin() const {
-    return Iterator {table, table + table_size, 0};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::page_begin(size_type number) {
+    if constexpr (Traits::overflow == ADS_set_overflow::geometric) {
+        return N << number;
+    } else {
+        return (number + 1) * N;
+    }
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::const_iterator ADS_set<Key, N>::end() const {
-    auto end {table + table_size};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Page* ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::page(size_type number) const {
+    Page* page {overflow};
+
+    // Walk from the newest page back to the requested one
+    for (size_type i {page_count() - 1}; i > number; --i) {
+        page = page->next;
+    }
 
-    return Iterator {end, end, 0};
+    return page;
 }
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::dump(std::ostream& o) const {
-    o << "split_round = " << split_round;
-    o << ", table_split_index = " << table_split_index;
-    o << ", table_size = " << table_size;
-    o << ", table_items_size = " << table_items_size;
-    o << "\n\n";
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::prefetch_overflow() const {
+    if (overflow == nullptr) return;
 
-    for (size_type i {0}; i < table_size; ++i) {
-        o << (table_split_index == i ? "-> " : "   ");
-        o << std::setfill(' ') << std::setw(4) << i << " | ";
-        table[i].dump(o);
-        o << "\n";
+    __builtin_prefetch(overflow->raw(0));
+
+    if constexpr (has_fingerprints) {
+        __builtin_prefetch(overflow->fingerprints(page_capacity(page_count() - 1)));
     }
+}
 
-    o << "\n";
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Page* ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::page_after(size_type index, Page* current) const {
+    // The oldest page follows the inline values, it is only reached by one walk per bucket
+    if (index + 1 == N) return overflow == nullptr ? nullptr : page(0);
+    if (index + 1 < N) return nullptr;
+
+    return index + 1 == page_begin(page_number(index) + 1) ? current->newer : current;
 }
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::Bucket::Bucket() : values_capacity {N}, values {new value_type[values_capacity]} {}
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Visit>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::for_each(Visit visit) {
+    Page* current {nullptr};
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::Bucket::~Bucket() {
-    delete[] values;
+    for (size_type i {0}; i < values_size; current = page_after(i++, current)) {
+        visit(at(i, current), fingerprint_at(i, current));
+    }
 }
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::Bucket::Bucket(const Bucket& other) : Bucket {} {
-    swap(other);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Visit>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::for_each(Visit visit) const {
+    const_cast<Bucket*>(this)->for_each([&](const value_type& value, fingerprint_type fingerprint) {
+        visit(value, fingerprint);
+    });
 }
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::Bucket::Bucket(Bucket&& other) noexcept: Bucket {} {
-    swap(other);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::expand(Pool& pool) {
+    const size_type number {page_count()};
+    Page* page {pool.allocate(page_class(number))};
+
+    pool.counters().add(ADS_set_event::expansion);
+
+    // Clear the tags, including the padding compared along with them
+    if constexpr (Traits::fingerprint == ADS_set_fingerprint::tag) {
+        fingerprint_type* fingerprints {page->fingerprints(page_capacity(number))};
+
+        for (size_type i {0}; i < fingerprints_size(page_capacity(number)); ++i) {
+            fingerprints[i] = 0;
+        }
+    }
+
+    // The new page becomes the newest page
+    page->next = overflow;
+
+    if (overflow != nullptr) overflow->newer = page;
+
+    overflow = page;
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::Bucket& ADS_set<Key, N>::Bucket::operator=(Bucket other) {
-    swap(other);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::pop_back(Pool& pool) {
+    const size_type index {values_size - 1};
 
-    return *this;
+    (*this)[index].~value_type();
+    --values_size;
+
+    // Return the newest overflow page if it became empty
+    if (index >= N && index == page_begin(page_number(index))) {
+        Page* page {overflow};
+        overflow = page->next;
+
+        if (overflow != nullptr) overflow->newer = nullptr;
+
+        pool.release(page, page_class(page_number(index)));
+    }
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::reference ADS_set<Key, N>::Bucket::operator[](size_type index) {
-    return values[index];
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::fingerprint_type ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::fingerprint_at(size_type index, const Page* current) const {
+    if (!has_fingerprints || index < N) return Fingerprints::get(index);
+
+    const size_type number {page_number(index)};
+
+    return current->fingerprints(page_capacity(number))[index - page_begin(number)];
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::const_reference ADS_set<Key, N>::Bucket::operator[](size_type index) const {
-    return values[index];
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Equal>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::find_in(const fingerprint_type* fingerprints, size_type count,
+                                         fingerprint_type fingerprint, Equal equal) {
+    if constexpr (Traits::fingerprint == ADS_set_fingerprint::tag) {
+        for (size_type begin {0}, width {0}; begin < count; begin += width) {
+            // Compare two groups per step while the padded tags hold both
+            width = count - begin > tag_group_size ? 2 * tag_group_size : tag_group_size;
+            unsigned matches {width == tag_group_size ? match_tags(fingerprints + begin, fingerprint) :
+                              match_tag_pair(fingerprints + begin, fingerprint)};
+
+            // Ignore the padding behind the last value
+            if (count - begin < width) {
+                matches &= (1u << (count - begin)) - 1;
+            }
+
+            // Only compare the keys whose tags matched
+            for (; matches != 0; matches &= matches - 1) {
+                const size_type i {begin + __builtin_ctz(matches)};
+
+                if (equal(i)) return i;
+            }
+        }
+    } else {
+        for (size_type i {0}; i < count; ++i) {
+            if ((!has_fingerprints || fingerprints[i] == fingerprint) && equal(i)) {
+                return i;
+            }
+        }
+    }
+
+    return count;
 }
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::Bucket::expand() {
-    size_type new_values_capacity {values_size + N};
-    value_type* new_values {new value_type[new_values_capacity]};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Position
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::index_of(const K& key, fingerprint_type fingerprint,
+                                                          const key_equal& equal) const {
+    if constexpr (scans_inline_values && std::is_same_v<K, key_type>) {
+        constexpr size_type vector_values {value_vector_size / sizeof(key_type)};
+        unsigned matches {0};
+
+        // Compare all inline values without branches and ignore the unused ones afterwards
+        for (size_type i {0}; i < N; i += vector_values) {
+            matches |= match_values(values.data() + i * sizeof(key_type), key) << i;
+        }
+
+        if (values_size < N) matches &= (1u << values_size) - 1;
+        if (matches != 0) return {static_cast<size_type>(__builtin_ctz(matches)), nullptr};
+        if (values_size <= N) return {values_size, nullptr};
+    } else {
+        const size_type inline_size {values_size < N ? values_size : N};
+        const size_type inline_index {find_in(Fingerprints::data(), inline_size, fingerprint, [&](size_type i) {
+            return equal(values[i], key);
+        })};
+
+        if (inline_index != inline_size) return {inline_index, nullptr};
+    }
+
+    // Continue in the overflow pages, starting with the newest one
+    size_type end {values_size};
+    size_type number {page_count()};
+
+    for (Page* page {overflow}; page != nullptr; page = page->next) {
+        const size_type begin {page_begin(--number)};
+        const size_type page_index {find_in(page->fingerprints(page_capacity(number)), end - begin, fingerprint,
+                                            [&](size_type i) { return equal(std::as_const(*page)[i], key); })};
 
-    // Copy/Move values to new_values
-    for (size_type i {0}; i < values_size; ++i) {
-        new_values[i] = std::move(values[i]);
+        if (page_index != end - begin) return {begin + page_index, page};
+
+        end = begin;
     }
 
-    // Free memory
-    delete[] values;
+    return {values_size, nullptr};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K>
+const typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::value_type*
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::locate(const K& key, fingerprint_type fingerprint,
+                                                        const key_equal& equal) const {
+    const Position found {index_of(key, fingerprint, equal)};
+
+    if (found.index == values_size) return nullptr;
 
-    // Update values and capacity
-    values = std::move(new_values);
-    values_capacity = new_values_capacity;
+    return &at(found.index, found.page);
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::size_type ADS_set<Key, N>::Bucket::index_of(const ADS_set::key_type& key) const {
-    for (size_type i {0}; i < values_size; ++i) {
-        if (key_equal {}(values[i], key)) {
-            return i;
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename... Args>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::emplace_back(fingerprint_type fingerprint, Pool& pool,
+                                                                   Args&&... args) {
+    // If size exceeds capacity, expand it
+    if (values_size >= N && full()) expand(pool);
+
+    // Store key in the inline values or the newest page and increase bucket's size
+    if (values_size < N) {
+        new (values.raw(values_size)) value_type(std::forward<Args>(args)...);
+        Fingerprints::set(values_size, fingerprint);
+    } else {
+        const size_type number {page_number(values_size)};
+        const size_type offset {values_size - page_begin(number)};
+
+        new (overflow->raw(offset)) value_type(std::forward<Args>(args)...);
+
+        if constexpr (has_fingerprints) {
+            overflow->fingerprints(page_capacity(number))[offset] = fingerprint;
         }
     }
 
-    return values_capacity;
+    ++values_size;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::count(const K& key, fingerprint_type fingerprint,
+                                                       const key_equal& equal) const {
+    return locate(key, fingerprint, equal) != nullptr;
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::value_type* ADS_set<Key, N>::Bucket::locate(const key_type& key) const {
-    size_type index {index_of(key)};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename K>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::erase(const K& key, fingerprint_type fingerprint,
+                                                       const key_equal& equal, Pool& pool) {
+    const Position found {index_of(key, fingerprint, equal)};
+
+    // Do not erase anything if value couldn't be found
+    if (found.index == values_size) return 0;
 
-    if (index == values_capacity) return nullptr;
+    remove_at(found.index, found.page, pool);
 
-    return &values[index];
+    return 1;
 }
 
-template<typename Key, size_t N>
-std::pair<typename ADS_set<Key, N>::size_type, bool> ADS_set<Key, N>::Bucket::insert(key_type key) {
-    size_type index {index_of(key)};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::remove_at(size_type index, Page* current, Pool& pool) {
+    // Replace the value with the last item and decrease bucket's size, the last item is in the newest page
+    if (index != values_size - 1) {
+        Page* last_page {values_size > N ? overflow : nullptr};
 
-    // Ignore insert if key already exists
-    if (index != values_capacity) {
-        return {index, false};
+        at(index, current) = std::move(at(values_size - 1, last_page));
+
+        if constexpr (has_fingerprints) {
+            const fingerprint_type last_fingerprint {fingerprint_at(values_size - 1, last_page)};
+
+            if (index < N) {
+                Fingerprints::set(index, last_fingerprint);
+            } else {
+                const size_type number {page_number(index)};
+                current->fingerprints(page_capacity(number))[index - page_begin(number)] = last_fingerprint;
+            }
+        }
     }
 
-    // If size exceeds capacity, expand it
-    if (values_size >= values_capacity) expand();
+    pop_back(pool);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Predicate>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::remove_if(Predicate removes, Pool& pool) {
+    const size_type old_size {values_size};
+    Page* current {values_size > N ? overflow : nullptr};
+
+    // Walk backwards, so the last value replacing a removed one has been checked already
+    for (size_type i {values_size}; i-- > 0;) {
+        // Removing the value may release its page, so the page of the value before is taken first
+        Page* before {i == 0 ? nullptr : page_before(i, current)};
 
-    // Store key and increase bucket's size
-    values[index = values_size++] = std::move(key);
+        if (removes(std::as_const(at(i, current)), fingerprint_at(i, current))) remove_at(i, current, pool);
 
-    return {index, true};
+        current = before;
+    }
+
+    return old_size - values_size;
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::size_type ADS_set<Key, N>::Bucket::count(const key_type& key) const {
-    return locate(key) != nullptr;
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::append(const Bucket& other, Pool& pool) {
+    other.for_each([&](const value_type& value, fingerprint_type fingerprint) {
+        emplace_back(fingerprint, pool, value);
+    });
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::size_type ADS_set<Key, N>::Bucket::erase(const ADS_set::key_type& key) {
-    size_type index {index_of(key)};
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Predicate>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::partition(Predicate moves, Bucket& target, Pool& pool) {
+    partition_some(moves, target, pool, 0, values_size);
+}
 
-    // Do not erase anything if value couldn't be found
-    if (index == values_capacity) return 0;
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+template<typename Predicate>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::size_type
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::partition_some(Predicate moves, Bucket& target, Pool& pool, size_type begin,
+                                                                  size_type count) {
+    size_type i {begin};
+    Page* current {begin < values_size ? page_of(begin) : nullptr};
 
-    // Replace found value with the last item and decrease bucket's size
-    values[index] = std::move(values[--values_size]);
+    for (; i < values_size && count > 0; --count) {
+        const fingerprint_type fingerprint {fingerprint_at(i, current)};
 
-    return 1;
+        if (moves(std::as_const(at(i, current)), fingerprint)) {
+            target.emplace_back(fingerprint, pool, std::move(at(i, current)));
+
+            // The last value takes the freed slot, so index i is checked again
+            remove_at(i, current, pool);
+        } else {
+            current = page_after(i++, current);
+        }
+    }
+
+    return i;
 }
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::Bucket::swap(Bucket& other) {
-    using std::swap;
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::clear(Pool& pool) {
+    while (values_size > 0) {
+        pop_back(pool);
+    }
+}
 
-    swap(values_size, other.values_size);
-    swap(values_capacity, other.values_capacity);
-    swap(values, other.values);
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::relocate(Pool& pool) {
+    Page** link {&overflow};
+    Page* newer_page {nullptr};
+    size_type end {values_size};
+    size_type number {page_count()};
+
+    // Replace each overflow page by a page of the same class from the given pool
+    for (Page* page {overflow}; page != nullptr; page = page->next) {
+        const size_type begin {page_begin(--number)};
+        Page* new_page {pool.allocate(page_class(number))};
+
+        for (size_type i {begin}; i < end; ++i) {
+            new (new_page->raw(i - begin)) value_type(std::move((*page)[i - begin]));
+            (*page)[i - begin].~value_type();
+
+            if constexpr (has_fingerprints) {
+                new_page->fingerprints(page_capacity(number))[i - begin] =
+                        page->fingerprints(page_capacity(number))[i - begin];
+            }
+        }
+
+        *link = new_page;
+        new_page->newer = newer_page;
+        newer_page = new_page;
+        link = &new_page->next;
+        end = begin;
+    }
 }
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::Bucket::dump(std::ostream& o) const {
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Bucket::dump(std::ostream& o) const {
     o << "(size: " << std::setfill(' ') << std::setw(2) << values_size << ", ";
-    o << "capacity: " << std::setfill(' ') << std::setw(2) << values_capacity << ") | ";
+    o << "capacity: " << std::setfill(' ') << std::setw(2) << capacity() << ") | ";
 
-    for (size_type i {0}; i < values_size; ++i) {
-        if (i > 0 && i % N == 0) o << " -> | ";
-        o << values[i] << " ";
-    }
+    size_type i {0};
+
+    for_each([&](const value_type& value, fingerprint_type) {
+        if (i >= N && i == page_begin(page_number(i))) o << " -> | ";
+        o << value << " ";
+        ++i;
+    });
 }
 
-template<typename Key, size_t N>
-void ADS_set<Key, N>::Iterator::skip_empty_buckets() {
-    while (current != end && current->size() == 0) {
-        ++current;
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator::seek(bucket_size_type from) {
+    // Empty buckets are skipped by their occupancy bits without touching them
+    bucket_index = ADS_set::next_occupied(occupancy, from, end);
+
+    if (bucket_index == end) {
+        current = nullptr;
+    } else {
+        const bucket_size_type segment {ADS_set::segment_of(bucket_index)};
+        current = &segments[segment][bucket_index - ADS_set::segment_begin(segment)];
     }
 }
 
-template<typename Key, size_t N>
-ADS_set<Key, N>::Iterator::Iterator(bucket_pointer current, bucket_pointer end, bucket_size_type index) :
-        current {current}, end {end}, index {index} {
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator::Iterator(const bucket_pointer* segments,
+                                                           const bucket_size_type* const* occupancy,
+                                                           bucket_size_type bucket_index, bucket_size_type end,
+                                                           bucket_size_type index) :
+        segments {segments}, occupancy {occupancy}, bucket_index {bucket_index}, end {end}, index {index} {
+    if (bucket_index == end) return;
+
+    const bucket_size_type segment {ADS_set::segment_of(bucket_index)};
+    current = &segments[segment][bucket_index - ADS_set::segment_begin(segment)];
+
     if (index >= current->size()) {
         this->index = 0;
-        skip_empty_buckets();
+        seek(bucket_index);
+    } else {
+        page = current->page_of(index);
     }
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::Iterator::reference ADS_set<Key, N>::Iterator::operator*() const {
-    return (*current)[index];
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator::Iterator(const bucket_pointer* segments,
+                                                           const bucket_size_type* const* occupancy,
+                                                           bucket_size_type bucket_index, bucket_size_type end,
+                                                           bucket_size_type index, page_pointer page) :
+        segments {segments}, occupancy {occupancy}, bucket_index {bucket_index}, end {end}, index {index},
+        page {page} {
+    const bucket_size_type segment {ADS_set::segment_of(bucket_index)};
+    current = &segments[segment][bucket_index - ADS_set::segment_begin(segment)];
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator::reference ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator::operator*() const {
+    return current->at(index, page);
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::Iterator::pointer ADS_set<Key, N>::Iterator::operator->() const {
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator::pointer ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator::operator->() const {
     return &(operator*());
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::Iterator& ADS_set<Key, N>::Iterator::operator++() {
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator& ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator::operator++() {
     // Do not advance when we reached the end bucket
-    if (current == end) {
+    if (bucket_index == end) {
         return *this;
     }
 
-    // Increment the bucket index
+    // Increment the bucket index, the following value's page is reached from the current one
+    page = current->page_after(index, page);
     ++index;
 
     // Go to next non-empty bucket
     if (index >= current->size()) {
         index = 0;
-        ++current;
-
-        skip_empty_buckets();
+        page = nullptr;
+        seek(bucket_index + 1);
     }
 
     return *this;
 }
 
-template<typename Key, size_t N>
-typename ADS_set<Key, N>::Iterator ADS_set<Key, N>::Iterator::operator++(int) {
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+typename ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>::Iterator::operator++(int) {
     Iterator tmp {*this};
     ++*this;
     return tmp;
 }
 
-template<typename Key, size_t N>
-void swap(ADS_set<Key, N>& first, ADS_set<Key, N>& second) {
-    first.swap(second);
-}
-
-template<typename Key, size_t N>
-void swap(typename ADS_set<Key, N>::Bucket& first, typename ADS_set<Key, N>::Bucket& second) {
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, typename Allocator>
+void swap(ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>& first, ADS_set<Key, N, Hash, KeyEqual, Traits, Allocator>& second) {
     first.swap(second);
 }
 
@@ -0,0 +1,246 @@
+#ifndef ADS_THREAD_POOL_H
+#define ADS_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+/**
+ * Fixed pool of worker threads running one parallel loop at a time. The calling thread
+ * takes part in every loop, so a pool of size n starts n - 1 workers. Loops started from
+ * inside a loop run on the calling thread.
+ */
+class ADS_thread_pool {
+public:
+    using size_type = size_t;
+private:
+    /** Worker threads */
+    std::thread* workers {nullptr};
+
+    /** Amount of worker threads */
+    size_type workers_size {0};
+
+    /** Serializes the loops started by different threads */
+    std::mutex loop_mutex;
+
+    /** Guards the loop state below */
+    std::mutex mutex;
+
+    /** Signals workers that a loop started or the pool stops */
+    std::condition_variable loop_started;
+
+    /** Signals the calling thread that a worker finished its part */
+    std::condition_variable worker_finished;
+
+    /** Number of the current loop, workers take part once per loop */
+    size_type generation {0};
+
+    /** Amount of workers that finished the current loop */
+    size_type finished {0};
+
+    /** Whether the workers should stop */
+    bool stopping {false};
+
+    /** Calls the loop body for an index */
+    void (*invoke)(void* body, size_type index) {nullptr};
+
+    /** Loop body of the current loop */
+    void* body {nullptr};
+
+    /** Amount of indices of the current loop */
+    size_type loop_size {0};
+
+    /** Next index to run */
+    std::atomic<size_type> next_index {0};
+
+    /** First exception thrown by the loop body */
+    std::exception_ptr error {nullptr};
+
+    /**
+     * Get whether the current thread is running a loop.
+     *
+     * @return reference to the thread's flag
+     */
+    static bool& inside_loop() {
+        static thread_local bool inside {false};
+
+        return inside;
+    }
+
+    /**
+     * Run indices of the current loop until none are left.
+     */
+    void run_indices();
+
+    /**
+     * Stop and join the started worker threads.
+     */
+    void stop();
+
+    /**
+     * Body of a worker thread.
+     */
+    void work();
+
+public:
+    /**
+     * Creates a pool that runs loops on the given amount of threads.
+     *
+     * @param threads amount of threads including the calling thread, all hardware threads by default
+     */
+    explicit ADS_thread_pool(size_type threads = std::thread::hardware_concurrency());
+
+    /**
+     * Stops and joins the worker threads.
+     */
+    ~ADS_thread_pool();
+
+    ADS_thread_pool(const ADS_thread_pool&) = delete;
+
+    ADS_thread_pool& operator=(const ADS_thread_pool&) = delete;
+
+    /**
+     * Get the pool shared by all sets that aren't given a pool.
+     *
+     * @return reference to the shared pool
+     */
+    static ADS_thread_pool& shared() {
+        static ADS_thread_pool pool;
+
+        return pool;
+    }
+
+    /**
+     * Get the amount of threads a loop runs on.
+     *
+     * @return amount of threads including the calling thread
+     */
+    [[nodiscard]] size_type size() const { return workers_size + 1; }
+
+    /**
+     * Call a function for every index in [0, count) on the pool's threads and wait until all
+     * calls returned. The first exception thrown is rethrown after the remaining indices are skipped.
+     *
+     * @tparam Function type of function
+     * @param count amount of indices
+     * @param function function called with each index
+     */
+    template<typename Function>
+    void parallel_for(size_type count, Function function);
+};
+
+inline ADS_thread_pool::ADS_thread_pool(size_type threads) {
+    if (threads > 1) {
+        workers = new std::thread[threads - 1];
+
+        // Count the started workers, so a failing start joins exactly those
+        try {
+            for (; workers_size < threads - 1; ++workers_size) {
+                workers[workers_size] = std::thread {&ADS_thread_pool::work, this};
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+}
+
+inline ADS_thread_pool::~ADS_thread_pool() {
+    stop();
+}
+
+inline void ADS_thread_pool::stop() {
+    {
+        std::lock_guard<std::mutex> lock {mutex};
+        stopping = true;
+    }
+
+    loop_started.notify_all();
+
+    for (size_type i {0}; i < workers_size; ++i) {
+        workers[i].join();
+    }
+
+    delete[] workers;
+    workers = nullptr;
+    workers_size = 0;
+}
+
+inline void ADS_thread_pool::run_indices() {
+    for (size_type index {next_index.fetch_add(1)}; index < loop_size; index = next_index.fetch_add(1)) {
+        try {
+            invoke(body, index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock {mutex};
+
+            // Keep the first exception and skip the remaining indices
+            if (!error) error = std::current_exception();
+            next_index.store(loop_size);
+        }
+    }
+}
+
+inline void ADS_thread_pool::work() {
+    inside_loop() = true;
+
+    size_type seen {0};
+    std::unique_lock<std::mutex> lock {mutex};
+
+    for (;;) {
+        loop_started.wait(lock, [&] { return stopping || generation != seen; });
+
+        if (stopping) return;
+
+        seen = generation;
+        lock.unlock();
+
+        run_indices();
+
+        lock.lock();
+
+        if (++finished == workers_size) worker_finished.notify_one();
+    }
+}
+
+template<typename Function>
+void ADS_thread_pool::parallel_for(size_type count, Function function) {
+    // Small and nested loops run on the calling thread
+    if (workers_size == 0 || count <= 1 || inside_loop()) {
+        for (size_type index {0}; index < count; ++index) {
+            function(index);
+        }
+
+        return;
+    }
+
+    std::lock_guard<std::mutex> loop_lock {loop_mutex};
+
+    {
+        std::lock_guard<std::mutex> lock {mutex};
+
+        invoke = [](void* loop_body, size_type index) { (*static_cast<Function*>(loop_body))(index); };
+        body = &function;
+        loop_size = count;
+        next_index.store(0);
+        finished = 0;
+        error = nullptr;
+        ++generation;
+    }
+
+    loop_started.notify_all();
+
+    inside_loop() = true;
+    run_indices();
+    inside_loop() = false;
+
+    // Every worker takes part in every loop, so the body is only released after all of them are done
+    std::unique_lock<std::mutex> lock {mutex};
+    worker_finished.wait(lock, [&] { return finished == workers_size; });
+
+    if (error) std::rethrow_exception(error);
+}
+
+#endif // ADS_THREAD_POOL_H
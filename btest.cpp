@@ -0,0 +1,344 @@
+/**
+ * Stress test of concurrent_ADS_set, built by the btest target.
+ *
+ * Threads insert, erase and look up keys at once while the table splits, then the final contents
+ * are checked exactly, by lookups and by for_each(). Build it with -fsanitize=thread to check the
+ * set for data races, or with -fsanitize=address to check that retired nodes are only freed once
+ * no reader can see them anymore. Failures are printed to stderr and end the test with status 1.
+ *
+ * Usage: btest [--size n] [--rounds r] [--threads t]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "concurrent_ADS_set.h"
+
+/**
+ * Hash giving every two consecutive keys the same hash, so lookups have to compare values with
+ * equal hashes.
+ */
+struct paired_hash {
+    size_t operator()(size_t key) const { return std::hash<size_t> {}(key >> 1); }
+};
+
+/**
+ * End the test as failed if a result isn't the expected one.
+ *
+ * @param condition whether the result is as expected
+ * @param what description of the result
+ */
+void expect(bool condition, const char* what) {
+    if (condition) return;
+
+    std::fprintf(stderr, "unexpected result: %s\n", what);
+    std::_Exit(1);
+}
+
+/**
+ * Options given on the command line.
+ */
+struct Options {
+    /** Amount of keys owned by every thread */
+    size_t size {size_t {1} << 14};
+
+    /** How many times every thread inserts and erases its keys */
+    size_t rounds {4};
+
+    /** Amount of writing threads, a thread calling for_each() runs besides them */
+    size_t threads {std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 8)};
+};
+
+/**
+ * Create the key with the given number. String keys are too long for the small string
+ * optimization, so freeing a node too early shows as a use after free.
+ *
+ * @tparam Key key type
+ * @param number number of the key
+ * @return the key
+ */
+template<typename Key>
+Key make_key(size_t number);
+
+template<>
+size_t make_key<size_t>(size_t number) {
+    return number;
+}
+
+template<>
+std::string make_key<std::string>(size_t number) {
+    return "stress test key number " + std::to_string(number);
+}
+
+/**
+ * Start all threads of a case at once, so their operations overlap.
+ */
+class StartSignal {
+    std::atomic<size_t> waiting;
+
+public:
+    explicit StartSignal(size_t threads) : waiting {threads} {}
+
+    void arrive_and_wait() {
+        waiting.fetch_sub(1);
+
+        while (waiting.load() > 0) std::this_thread::yield();
+    }
+};
+
+/**
+ * Check the contents of a set exactly: its size, a lookup of every key that may have been
+ * inserted, and that for_each() visits every expected key once and nothing else.
+ *
+ * @tparam Set set type
+ * @tparam Key key type
+ * @param set the set to check
+ * @param universe every key that may have been inserted
+ * @param expected whether each key of the universe has to be in the set
+ */
+template<typename Set, typename Key>
+void check_contents(Set& set, const std::vector<Key>& universe, const std::vector<bool>& expected) {
+    std::unordered_map<Key, size_t> numbers;
+    size_t expected_size {0};
+
+    for (size_t i {0}; i < universe.size(); ++i) {
+        numbers.emplace(universe[i], i);
+        expected_size += expected[i];
+        expect(set.contains(universe[i]) == expected[i], "final lookup");
+        expect(set.find(universe[i]).has_value() == expected[i], "final find");
+    }
+
+    expect(set.size() == expected_size, "final size");
+
+    std::vector<size_t> visits(universe.size());
+
+    set.for_each([&](const Key& key) {
+        const auto number {numbers.find(key)};
+
+        expect(number != numbers.end(), "visited key was never inserted");
+        ++visits[number->second];
+    });
+
+    for (size_t i {0}; i < universe.size(); ++i) expect(visits[i] == expected[i], "final visits");
+}
+
+/**
+ * Every thread inserts and erases keys only it owns, so each of its results is known exactly.
+ * Besides that every thread looks up stable keys, which are inserted before the threads start and
+ * never erased, and keys that are never inserted. Another thread calls for_each() during the
+ * whole case, which has to visit every stable key exactly once.
+ *
+ * @tparam Set set type
+ * @tparam Key key type
+ * @param options command line options
+ */
+template<typename Set, typename Key>
+void run_owned_keys(const Options& options) {
+    const size_t owned {options.threads * options.size};
+    const size_t stable {options.size};
+    std::vector<Key> universe;
+
+    for (size_t i {0}; i < owned + stable; ++i) universe.push_back(make_key<Key>(i));
+
+    const std::vector<Key> never_inserted {make_key<Key>(owned + stable), make_key<Key>(owned + stable + 1),
+                                           make_key<Key>(owned + stable + 7)};
+    std::unordered_map<Key, size_t> numbers;
+    std::vector<bool> expected(universe.size());
+    Set set;
+
+    for (size_t i {0}; i < universe.size(); ++i) numbers.emplace(universe[i], i);
+
+    for (size_t i {owned}; i < owned + stable; ++i) {
+        expect(set.insert(universe[i]), "stable insert");
+        expected[i] = true;
+    }
+
+    StartSignal start {options.threads + 1};
+    std::atomic<size_t> writing {options.threads};
+    std::vector<std::vector<bool>> remaining(options.threads);
+    std::vector<std::thread> workers;
+
+    const auto write = [&](size_t thread) {
+        const size_t begin {thread * options.size};
+        const size_t end {begin + options.size};
+        std::mt19937_64 random {thread};
+        std::vector<bool> present(options.size);
+
+        start.arrive_and_wait();
+
+        for (size_t round {0}; round < options.rounds; ++round) {
+            for (size_t i {begin}; i < end; ++i) {
+                expect(set.insert(universe[i]) != present[i - begin], "owned insert");
+                present[i - begin] = true;
+                expect(set.contains(universe[owned + random() % stable]), "stable lookup");
+            }
+
+            for (size_t i {begin}; i < end; ++i) {
+                const bool erasing {(i + round) % 3 != 0};
+
+                if (erasing) {
+                    expect(set.erase(universe[i]) == 1, "owned erase");
+                    present[i - begin] = false;
+                }
+
+                expect(set.contains(universe[i]) == present[i - begin], "owned lookup");
+                expect(!set.contains(never_inserted[random() % never_inserted.size()]), "lookup of missing key");
+            }
+        }
+
+        remaining[thread] = std::move(present);
+        writing.fetch_sub(1);
+    };
+
+    for (size_t thread {0}; thread < options.threads; ++thread) workers.emplace_back(write, thread);
+
+    start.arrive_and_wait();
+
+    // Values inserted or erased during for_each may or may not be visited, stable keys must be
+    while (writing.load() > 0) {
+        std::vector<size_t> visits(stable);
+
+        set.for_each([&](const Key& key) {
+            const auto number {numbers.find(key)};
+
+            expect(number != numbers.end(), "visited key was never inserted");
+
+            if (number->second >= owned) ++visits[number->second - owned];
+        });
+
+        for (size_t visit_count : visits) expect(visit_count == 1, "visits of stable keys");
+    }
+
+    for (std::thread& worker : workers) worker.join();
+
+    for (size_t thread {0}; thread < options.threads; ++thread) {
+        std::copy(remaining[thread].begin(), remaining[thread].end(), expected.begin() + thread * options.size);
+    }
+
+    check_contents(set, universe, expected);
+}
+
+/**
+ * All threads insert, erase and look up the same few keys in random order. Every successful
+ * insert and erase is counted per key, so the final presence of each key is known once the
+ * threads are done.
+ *
+ * @tparam Set set type
+ * @tparam Key key type
+ * @param options command line options
+ */
+template<typename Set, typename Key>
+void run_shared_keys(const Options& options) {
+    const size_t keys {std::max<size_t>(options.size / 16, 2)};
+    std::vector<Key> universe;
+
+    for (size_t i {0}; i < keys; ++i) universe.push_back(make_key<Key>(i));
+
+    std::vector<std::atomic<long>> balance(keys);
+    Set set;
+    StartSignal start {options.threads};
+    std::vector<std::thread> workers;
+
+    const auto work = [&](size_t thread) {
+        std::mt19937_64 random {thread + 1000};
+
+        start.arrive_and_wait();
+
+        for (size_t operation {0}; operation < options.rounds * options.size; ++operation) {
+            const size_t number {random() % keys};
+
+            switch (random() % 3) {
+            case 0:
+                if (set.insert(universe[number])) balance[number].fetch_add(1);
+                break;
+            case 1:
+                balance[number].fetch_sub(static_cast<long>(set.erase(universe[number])));
+                break;
+            default:
+                static_cast<void>(set.contains(universe[number]));
+            }
+        }
+    };
+
+    for (size_t thread {0}; thread < options.threads; ++thread) workers.emplace_back(work, thread);
+
+    for (std::thread& worker : workers) worker.join();
+
+    std::vector<bool> expected(keys);
+
+    for (size_t i {0}; i < keys; ++i) {
+        const long key_balance {balance[i].load()};
+
+        expect(key_balance == 0 || key_balance == 1, "inserts and erases of a key alternate");
+        expected[i] = key_balance == 1;
+    }
+
+    check_contents(set, universe, expected);
+}
+
+/**
+ * Run both cases for one set type.
+ *
+ * @tparam Set set type
+ * @param name name of the set type
+ * @param options command line options
+ */
+template<typename Set>
+void run_cases(const char* name, const Options& options) {
+    using Key = typename Set::key_type;
+
+    std::fprintf(stderr, "%s owned keys\n", name);
+    run_owned_keys<Set, Key>(options);
+    std::fprintf(stderr, "%s shared keys\n", name);
+    run_shared_keys<Set, Key>(options);
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+
+    for (int i {1}; i < argc; ++i) {
+        const std::string argument {argv[i]};
+        const bool has_value {i + 1 < argc};
+
+        if (argument == "--size" && has_value) {
+            options.size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--rounds" && has_value) {
+            options.rounds = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--threads" && has_value) {
+            options.threads = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--size n] [--rounds r] [--threads t]\n", argv[0]);
+            std::exit(2);
+        }
+    }
+
+    if (options.size == 0 || options.rounds == 0 || options.threads == 0) {
+        std::fprintf(stderr, "%s: size, rounds and threads have to be positive\n", argv[0]);
+        std::exit(2);
+    }
+
+    return options;
+}
+
+int main(int argc, char** argv) {
+    const Options options {parse_options(argc, argv)};
+
+    // Small buckets split often, so operations race with splits and retired nodes all the time
+    run_cases<concurrent_ADS_set<size_t, 1>>("concurrent_ADS_set<size_t,N=1>", options);
+    run_cases<concurrent_ADS_set<size_t, 5>>("concurrent_ADS_set<size_t,N=5>", options);
+    run_cases<concurrent_ADS_set<size_t, 2, paired_hash>>("concurrent_ADS_set<size_t,N=2,paired_hash>", options);
+    run_cases<concurrent_ADS_set<std::string, 3>>("concurrent_ADS_set<std::string,N=3>", options);
+
+    std::fprintf(stderr, "all cases passed\n");
+
+    return 0;
+}
@@ -0,0 +1,906 @@
+#ifndef CONCURRENT_ADS_SET_H
+#define CONCURRENT_ADS_SET_H
+
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+
+/**
+ * Set implemented with Linear hashing scheme, safe to use from many threads at once.
+ *
+ * Every bucket points to an immutable node holding its values. Writers lock the one bucket
+ * they modify and publish a modified copy of its node, splits publish the nodes of the split
+ * bucket and its partner bucket and are serialized by a split mutex. Readers never lock and
+ * never retry: they load a bucket's node and search it. Each node records the hash mask its
+ * values were distributed with, so a reader that raced with a split follows the key to the
+ * partner bucket.
+ *
+ * Replaced nodes are retired and freed once every reader that might still see them has left,
+ * tracked by reader counters per epoch parity. Buckets never move, since the table grows by
+ * segments, and buckets are never merged.
+ *
+ * @tparam Key key type
+ * @tparam N size of the buckets (b in lectures)
+ * @tparam Hash hash function object
+ * @tparam KeyEqual equality function object
+ */
+template<typename Key, size_t N = 5, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class concurrent_ADS_set {
+public:
+    using value_type = Key;
+    using key_type = Key;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using key_equal = KeyEqual;
+    using hasher = Hash;
+private:
+    class Node;
+
+    class Bucket;
+
+    class ReadSection;
+
+    /** Maximum amount of segments in the directory */
+    static constexpr size_type max_segments {sizeof(size_type) * CHAR_BIT};
+
+    /** Bits of the table state holding the split index, the split round is stored above them */
+    static constexpr size_type split_index_bits {sizeof(size_type) * CHAR_BIT - 8};
+
+    /** Amount of spins on a lock before yielding to other threads */
+    static constexpr unsigned spins_before_yield {64};
+
+    /** Size of a cache line, reader counters of different threads are kept apart by it */
+    static constexpr size_type cache_line_size {64};
+
+    /** Amount of reader counters, threads are spread over them */
+    static constexpr size_type reader_stripes {64};
+
+    /** Amount of retired nodes that are freed at once */
+    static constexpr size_type retire_batch_size {64};
+
+    /**
+     * Counters of active readers per epoch parity.
+     */
+    struct alignas(cache_line_size) ReaderCounters {
+        std::atomic<size_type> active[2];
+    };
+
+    /** Split round and index of next bucket that should be split, published at once */
+    std::atomic<size_type> state;
+
+    /** Number of total values stored in buckets */
+    std::atomic<size_type> items_size {0};
+
+    /** Amount of splits requested by inserts into full buckets */
+    std::atomic<size_type> pending_splits {0};
+
+    /** Directory of segments, segment 0 holds buckets [0, 2) and segment k > 0 holds buckets [2^k, 2^(k + 1)) */
+    std::atomic<Bucket*> segments[max_segments] {};
+
+    /** Serializes splits */
+    std::mutex split_mutex;
+
+    /** Epoch, whose parity selects the reader counters new readers enter */
+    std::atomic<size_type> epoch {0};
+
+    /** Reader counters per stripe */
+    mutable ReaderCounters readers[reader_stripes] {};
+
+    /** Guards the retired nodes and serializes waiting for readers */
+    std::mutex retire_mutex;
+
+    /** Retired nodes that may still be seen by readers */
+    Node* retired {nullptr};
+
+    /** Amount of retired nodes */
+    size_type retired_size {0};
+
+    /** Hash instance */
+    const hasher hash;
+
+    /** Key equality instance */
+    const key_equal equal;
+
+    /**
+     * Pack the split round and split index into a table state.
+     *
+     * @param split_round the split round
+     * @param split_index the split index
+     * @return the table state
+     */
+    static size_type pack_state(size_type split_round, size_type split_index) {
+        return split_round << split_index_bits | split_index;
+    }
+
+    /**
+     * Get the index of the bucket a key hash belongs to for a given table state.
+     *
+     * @param state the table state
+     * @param key_hash hash of the key
+     * @return index of bucket
+     */
+    static size_type bucket_index(size_type state, size_type key_hash);
+
+    /**
+     * Get the bucket a key moved to from a bucket whose node's mask doesn't match the key anymore.
+     * The first split that took the key away set the lowest differing bit, its partner bucket
+     * exists since that split.
+     *
+     * @param index index of bucket
+     * @param moved_bits bits of the node's mask in which the key hash and index differ
+     * @return index of the partner bucket the key moved to
+     */
+    static size_type follow(size_type index, size_type moved_bits) { return index | (moved_bits & (~moved_bits + 1)); }
+
+    /**
+     * Get the position of the most significant bit of a value.
+     *
+     * @param value a value greater than 0
+     * @return floor of the binary logarithm of value
+     */
+    static size_type floor_log2(size_type value) {
+        return sizeof(unsigned long long) * CHAR_BIT - 1 - __builtin_clzll(value);
+    }
+
+    /**
+     * Get the index of the segment that holds the bucket at the given index.
+     *
+     * @param index index of bucket
+     * @return index of segment
+     */
+    static size_type segment_of(size_type index) { return index < 2 ? 0 : floor_log2(index); }
+
+    /**
+     * Get the index of the first bucket in a segment.
+     *
+     * @param segment index of segment
+     * @return index of the segment's first bucket
+     */
+    static size_type segment_begin(size_type segment) { return segment == 0 ? 0 : size_type {1} << segment; }
+
+    /**
+     * Get the amount of buckets in a segment.
+     *
+     * @param segment index of segment
+     * @return amount of buckets
+     */
+    static size_type segment_size(size_type segment) { return segment == 0 ? 2 : size_type {1} << segment; }
+
+    /**
+     * Get the bucket at a given index, whose segment must have been published.
+     *
+     * @param index index of bucket
+     * @return reference to bucket
+     */
+    Bucket& bucket(size_type index) const;
+
+    /**
+     * Lock the bucket a key hash belongs to, following the key if the bucket was split meanwhile.
+     *
+     * @param key_hash hash of the key
+     * @return reference to the locked bucket
+     */
+    Bucket& lock_bucket(size_type key_hash) const;
+
+    /**
+     * Get the node holding the values a key hash belongs to. Requires a read section.
+     *
+     * @param key_hash hash of the key
+     * @return pointer to the node
+     */
+    const Node* read_node(size_type key_hash) const;
+
+    /**
+     * Split the next bucket that should be split, distributing its values between new nodes
+     * of the bucket and its partner bucket. Requires split_mutex to be held.
+     */
+    void split();
+
+    /**
+     * Run the pending splits unless another thread is splitting already.
+     */
+    void run_pending_splits();
+
+    /**
+     * Enter a read section, from which on retired nodes stay alive.
+     *
+     * @return the reader counter to leave with
+     */
+    std::atomic<size_type>& enter_read() const;
+
+    /**
+     * Wait until every read section that was active when calling has been left.
+     * Requires retire_mutex to be held.
+     */
+    void wait_for_readers();
+
+    /**
+     * Retire a replaced node, which is freed once no reader can see it anymore.
+     *
+     * @param node the node to retire
+     */
+    void retire(Node* node);
+
+public:
+    /**
+     * Creates an empty set.
+     */
+    concurrent_ADS_set() : concurrent_ADS_set {hasher {}} {}
+
+    /**
+     * Creates an empty set with the given function objects.
+     *
+     * @param hash the hash function object
+     * @param equal the equality function object
+     */
+    explicit concurrent_ADS_set(const hasher& hash, const key_equal& equal = key_equal {});
+
+    /**
+     * Delete the set. No other thread may use the set anymore.
+     */
+    ~concurrent_ADS_set();
+
+    /**
+     * Sets are shared by reference, they can't be copied.
+     */
+    concurrent_ADS_set(const concurrent_ADS_set&) = delete;
+
+    concurrent_ADS_set& operator=(const concurrent_ADS_set&) = delete;
+
+    /**
+     * Insert a given key.
+     *
+     * @param key the key to insert
+     * @return whether it was newly added
+     */
+    bool insert(const key_type& key) { return emplace_key(key, key); }
+
+    /**
+     * Insert a given key by moving it, which only happens if it doesn't exist yet.
+     *
+     * @param key the key to insert
+     * @return whether it was newly added
+     */
+    bool insert(key_type&& key) { return emplace_key(key, std::move(key)); }
+
+    /**
+     * Insert a value for a given key, which is only constructed if the key doesn't exist yet.
+     *
+     * @tparam Args types of the value's constructor arguments
+     * @param key the key to look up, the constructed value has to be equal to it
+     * @param args arguments to construct the value with
+     * @return whether it was newly added
+     */
+    template<typename... Args>
+    bool emplace_key(const key_type& key, Args&&... args);
+
+    /**
+     * Removes the given key from the set.
+     *
+     * @param key the key to remove
+     * @return the amount of removed elements
+     */
+    size_type erase(const key_type& key);
+
+    /**
+     * Finds the value equal to the given key without waiting for other threads.
+     *
+     * @param key the key to find
+     * @return copy of the found value; if nothing was found nothing
+     */
+    std::optional<value_type> find(const key_type& key) const;
+
+    /**
+     * Count how many times a key exists in the set (0 or 1) without waiting for other threads.
+     *
+     * @param key the key to count for
+     * @return how many times the key exists (0 or 1)
+     */
+    size_type count(const key_type& key) const { return contains(key); }
+
+    /**
+     * Check whether a key exists in the set without waiting for other threads.
+     *
+     * @param key the key to check
+     * @return whether the key exists
+     */
+    bool contains(const key_type& key) const;
+
+    /**
+     * Call a function for every value. Splits wait until it is done, values inserted or erased
+     * concurrently may or may not be visited. The function may look up values, but must not
+     * modify the set.
+     *
+     * @tparam Function type of function
+     * @param function function called with each value
+     */
+    template<typename Function>
+    void for_each(Function function);
+
+    /**
+     * Get the total amount of stored values, which may be outdated once it is returned.
+     *
+     * @return total amount of stored values
+     */
+    [[nodiscard]] size_type size() const { return items_size.load(std::memory_order_relaxed); }
+
+    /**
+     * Get whether the set is empty.
+     *
+     * @return if set is empty
+     */
+    [[nodiscard]] bool empty() const { return size() == 0; }
+};
+
+/**
+ * Immutable values of a bucket, followed in memory by the values' hashes and the values.
+ */
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+class concurrent_ADS_set<Key, N, Hash, KeyEqual>::Node {
+    /** Amount of values the node has room for */
+    size_type capacity;
+
+    /**
+     * Get the offset of the hashes behind the node.
+     *
+     * @return offset in bytes
+     */
+    static constexpr size_type hashes_offset() {
+        return (sizeof(Node) + alignof(size_type) - 1) / alignof(size_type) * alignof(size_type);
+    }
+
+    /**
+     * Get the offset of the values behind the hashes.
+     *
+     * @param capacity amount of values
+     * @return offset in bytes
+     */
+    static constexpr size_type values_offset(size_type capacity) {
+        const size_type end {hashes_offset() + capacity * sizeof(size_type)};
+
+        return (end + alignof(value_type) - 1) / alignof(value_type) * alignof(value_type);
+    }
+
+    /**
+     * Get the alignment of a node's memory.
+     *
+     * @return alignment of the node and its values
+     */
+    static constexpr std::align_val_t alignment() {
+        return std::align_val_t {alignof(Node) > alignof(value_type) ? alignof(Node) : alignof(value_type)};
+    }
+
+    /**
+     * Creates an empty node.
+     *
+     * @param mask the hash mask of the node's values
+     * @param capacity amount of values the node has room for
+     */
+    Node(size_type mask, size_type capacity) : capacity {capacity}, mask {mask} {}
+
+public:
+    /** Hash mask the values were distributed with, the bucket holds values whose masked hash is its index */
+    const size_type mask;
+
+    /** Amount of stored values */
+    size_type size {0};
+
+    /** Next retired node */
+    Node* retired {nullptr};
+
+    /**
+     * Allocate an empty node.
+     *
+     * @param mask the hash mask of the node's values
+     * @param capacity amount of values the node has room for
+     * @return pointer to the new node
+     */
+    static Node* create(size_type mask, size_type capacity);
+
+    /**
+     * Destroy the values of a node and free it.
+     *
+     * @param node the node to destroy
+     */
+    static void destroy(Node* node);
+
+    /**
+     * Get the hashes of the values.
+     *
+     * @return pointer to the first hash
+     */
+    size_type* hashes() { return reinterpret_cast<size_type*>(reinterpret_cast<unsigned char*>(this) + hashes_offset()); }
+
+    const size_type* hashes() const { return const_cast<Node*>(this)->hashes(); }
+
+    /**
+     * Get the value at an index.
+     *
+     * @param index index of value
+     * @return reference to value
+     */
+    value_type& operator[](size_type index) {
+        unsigned char* values {reinterpret_cast<unsigned char*>(this) + values_offset(capacity)};
+
+        return *std::launder(reinterpret_cast<value_type*>(values) + index);
+    }
+
+    const value_type& operator[](size_type index) const { return (*const_cast<Node*>(this))[index]; }
+
+    /**
+     * Get the index of a key, comparing hashes before keys.
+     *
+     * @param key the key to find
+     * @param key_hash hash of the key
+     * @param equal the equality function object
+     * @return Index of the found element; if it wasn't found the size of the node
+     */
+    size_type index_of(const key_type& key, size_type key_hash, const key_equal& equal) const;
+
+    /**
+     * Construct a value at the end of the node, which must still have room for it.
+     *
+     * @tparam Args types of the value's constructor arguments
+     * @param value_hash hash of the value
+     * @param args arguments to construct the value with
+     */
+    template<typename... Args>
+    void emplace_back(size_type value_hash, Args&&... args);
+};
+
+/**
+ * Bucket publishing its current node.
+ */
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+class concurrent_ADS_set<Key, N, Hash, KeyEqual>::Bucket {
+    /** Whether a writer holds the bucket */
+    std::atomic<bool> locked {false};
+
+public:
+    /** Current values of the bucket */
+    std::atomic<Node*> node {nullptr};
+
+    /**
+     * Lock the bucket against other writers.
+     */
+    void lock();
+
+    /**
+     * Unlock the bucket.
+     */
+    void unlock() { locked.store(false, std::memory_order_release); }
+};
+
+/**
+ * Read section, which keeps every node seen during it alive.
+ */
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+class concurrent_ADS_set<Key, N, Hash, KeyEqual>::ReadSection {
+    /** The entered reader counter */
+    std::atomic<size_type>& counter;
+
+public:
+    /**
+     * Enter a read section of a set.
+     *
+     * @param set the set to read
+     */
+    explicit ReadSection(const concurrent_ADS_set& set) : counter {set.enter_read()} {}
+
+    /**
+     * Leave the read section.
+     */
+    ~ReadSection() { counter.fetch_sub(1); }
+
+    ReadSection(const ReadSection&) = delete;
+
+    ReadSection& operator=(const ReadSection&) = delete;
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::concurrent_ADS_set(const hasher& hash, const key_equal& equal)
+        : state {pack_state(1, 0)}, hash {hash}, equal {equal} {
+    Bucket* initial {new Bucket[segment_size(0)]};
+
+    for (size_type i {0}; i < segment_size(0); ++i) {
+        initial[i].node.store(Node::create(1, 0), std::memory_order_relaxed);
+    }
+
+    segments[0].store(initial, std::memory_order_relaxed);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::~concurrent_ADS_set() {
+    for (size_type segment {0}; segment < max_segments; ++segment) {
+        Bucket* buckets {segments[segment].load(std::memory_order_relaxed)};
+
+        if (buckets == nullptr) continue;
+
+        for (size_type i {0}; i < segment_size(segment); ++i) {
+            if (Node* node {buckets[i].node.load(std::memory_order_relaxed)}) Node::destroy(node);
+        }
+
+        delete[] buckets;
+    }
+
+    while (retired != nullptr) {
+        Node* next {retired->retired};
+        Node::destroy(retired);
+        retired = next;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+typename concurrent_ADS_set<Key, N, Hash, KeyEqual>::size_type
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::bucket_index(size_type state, size_type key_hash) {
+    const size_type split_round {state >> split_index_bits};
+    const size_type split_index {state & ((size_type {1} << split_index_bits) - 1)};
+    const size_type index {key_hash & ((size_type {1} << split_round) - 1)};
+
+    // Use next split round's hash function for already split buckets
+    if (index < split_index) {
+        return key_hash & ((size_type {2} << split_round) - 1);
+    }
+
+    return index;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+typename concurrent_ADS_set<Key, N, Hash, KeyEqual>::Bucket&
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::bucket(size_type index) const {
+    const size_type segment {segment_of(index)};
+
+    return segments[segment].load(std::memory_order_acquire)[index - segment_begin(segment)];
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+typename concurrent_ADS_set<Key, N, Hash, KeyEqual>::Bucket&
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::lock_bucket(size_type key_hash) const {
+    size_type index {bucket_index(state.load(std::memory_order_acquire), key_hash)};
+
+    for (;;) {
+        Bucket& bucket {this->bucket(index)};
+
+        bucket.lock();
+
+        // A split replaces the node while holding the lock, its mask tells whether the key moved
+        const size_type moved_bits {(key_hash ^ index) & bucket.node.load(std::memory_order_relaxed)->mask};
+
+        if (moved_bits == 0) return bucket;
+
+        bucket.unlock();
+        index = follow(index, moved_bits);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+const typename concurrent_ADS_set<Key, N, Hash, KeyEqual>::Node*
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::read_node(size_type key_hash) const {
+    size_type index {bucket_index(state.load(std::memory_order_acquire), key_hash)};
+
+    for (;;) {
+        const Node* node {bucket(index).node.load()};
+        const size_type moved_bits {(key_hash ^ index) & node->mask};
+
+        if (moved_bits == 0) return node;
+
+        // Follow the key if the bucket was split after reading the state, at most once per split round
+        index = follow(index, moved_bits);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+void concurrent_ADS_set<Key, N, Hash, KeyEqual>::split() {
+    const size_type current_state {state.load(std::memory_order_relaxed)};
+    const size_type split_round {current_state >> split_index_bits};
+    const size_type split_index {current_state & ((size_type {1} << split_index_bits) - 1)};
+    const size_type partner_index {split_index + (size_type {1} << split_round)};
+
+    // Publish the segment of the partner bucket before any node can lead to it
+    const size_type segment {segment_of(partner_index)};
+
+    if (segments[segment].load(std::memory_order_relaxed) == nullptr) {
+        segments[segment].store(new Bucket[segment_size(segment)], std::memory_order_release);
+    }
+
+    Bucket& split_bucket {bucket(split_index)};
+    Bucket& partner_bucket {bucket(partner_index)};
+
+    split_bucket.lock();
+
+    Node* node {split_bucket.node.load(std::memory_order_relaxed)};
+    const size_type mask {(size_type {2} << split_round) - 1};
+    size_type moving {0};
+
+    for (size_type i {0}; i < node->size; ++i) {
+        moving += (node->hashes()[i] & mask) != split_index;
+    }
+
+    // Copy the values, since readers may still search the old node
+    Node* staying {Node::create(mask, node->size - moving)};
+    Node* moved {Node::create(mask, moving)};
+
+    try {
+        for (size_type i {0}; i < node->size; ++i) {
+            const size_type value_hash {node->hashes()[i]};
+
+            ((value_hash & mask) == split_index ? staying : moved)->emplace_back(value_hash, (*node)[i]);
+        }
+    } catch (...) {
+        Node::destroy(staying);
+        Node::destroy(moved);
+        split_bucket.unlock();
+        throw;
+    }
+
+    // The partner's node has to exist before the split bucket's node leads readers to it
+    partner_bucket.node.store(moved);
+    split_bucket.node.store(staying);
+
+    // Advance split round if all buckets have been split
+    if (split_index + 1 == size_type {1} << split_round) {
+        state.store(pack_state(split_round + 1, 0), std::memory_order_release);
+    } else {
+        state.store(pack_state(split_round, split_index + 1), std::memory_order_release);
+    }
+
+    split_bucket.unlock();
+    retire(node);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+void concurrent_ADS_set<Key, N, Hash, KeyEqual>::run_pending_splits() {
+    // Another thread that splits already takes over the pending splits
+    std::unique_lock<std::mutex> lock {split_mutex, std::try_to_lock};
+
+    if (!lock.owns_lock()) return;
+
+    size_type pending {pending_splits.load(std::memory_order_relaxed)};
+
+    while (pending > 0) {
+        if (pending_splits.compare_exchange_weak(pending, pending - 1, std::memory_order_relaxed)) {
+            split();
+            pending = pending_splits.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+std::atomic<typename concurrent_ADS_set<Key, N, Hash, KeyEqual>::size_type>&
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::enter_read() const {
+    static thread_local const size_type stripe {std::hash<std::thread::id> {}(std::this_thread::get_id()) % reader_stripes};
+
+    // Sequentially consistent, so either the writer sees this reader or the reader sees the replaced nodes unpublished
+    std::atomic<size_type>& counter {readers[stripe].active[epoch.load() % 2]};
+    counter.fetch_add(1);
+
+    return counter;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+void concurrent_ADS_set<Key, N, Hash, KeyEqual>::wait_for_readers() {
+    // Flip the parity twice, so readers that entered either parity before have left
+    for (size_type flip {0}; flip < 2; ++flip) {
+        const size_type parity {epoch.fetch_add(1) % 2};
+
+        for (const ReaderCounters& counters: readers) {
+            unsigned spins {0};
+
+            while (counters.active[parity].load() != 0) {
+                if (++spins == spins_before_yield) {
+                    spins = 0;
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+void concurrent_ADS_set<Key, N, Hash, KeyEqual>::retire(Node* node) {
+    Node* batch;
+
+    {
+        std::lock_guard<std::mutex> lock {retire_mutex};
+
+        node->retired = retired;
+        retired = node;
+
+        if (++retired_size < retire_batch_size) return;
+
+        batch = retired;
+        retired = nullptr;
+        retired_size = 0;
+
+        wait_for_readers();
+    }
+
+    while (batch != nullptr) {
+        Node* next {batch->retired};
+        Node::destroy(batch);
+        batch = next;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+template<typename... Args>
+bool concurrent_ADS_set<Key, N, Hash, KeyEqual>::emplace_key(const key_type& key, Args&&... args) {
+    const size_type key_hash {hash(key)};
+    Bucket& bucket {lock_bucket(key_hash)};
+    Node* node {bucket.node.load(std::memory_order_relaxed)};
+
+    // Ignore insert if key already exists
+    if (node->index_of(key, key_hash, equal) != node->size) {
+        bucket.unlock();
+
+        return false;
+    }
+
+    Node* grown {Node::create(node->mask, node->size + 1)};
+
+    try {
+        for (size_type i {0}; i < node->size; ++i) {
+            grown->emplace_back(node->hashes()[i], (*node)[i]);
+        }
+
+        grown->emplace_back(key_hash, std::forward<Args>(args)...);
+    } catch (...) {
+        Node::destroy(grown);
+        bucket.unlock();
+        throw;
+    }
+
+    const bool full {node->size >= N};
+
+    bucket.node.store(grown);
+    bucket.unlock();
+    items_size.fetch_add(1, std::memory_order_relaxed);
+    retire(node);
+
+    // Inserting into a full bucket splits the next bucket that should be split
+    if (full) {
+        pending_splits.fetch_add(1, std::memory_order_relaxed);
+        run_pending_splits();
+    }
+
+    return true;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+typename concurrent_ADS_set<Key, N, Hash, KeyEqual>::size_type
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::erase(const key_type& key) {
+    const size_type key_hash {hash(key)};
+    Bucket& bucket {lock_bucket(key_hash)};
+    Node* node {bucket.node.load(std::memory_order_relaxed)};
+    const size_type index {node->index_of(key, key_hash, equal)};
+
+    // Do not erase anything if value couldn't be found
+    if (index == node->size) {
+        bucket.unlock();
+
+        return 0;
+    }
+
+    Node* shrunk {Node::create(node->mask, node->size - 1)};
+
+    try {
+        for (size_type i {0}; i < node->size; ++i) {
+            if (i != index) shrunk->emplace_back(node->hashes()[i], (*node)[i]);
+        }
+    } catch (...) {
+        Node::destroy(shrunk);
+        bucket.unlock();
+        throw;
+    }
+
+    bucket.node.store(shrunk);
+    bucket.unlock();
+    items_size.fetch_sub(1, std::memory_order_relaxed);
+    retire(node);
+
+    return 1;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+std::optional<typename concurrent_ADS_set<Key, N, Hash, KeyEqual>::value_type>
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::find(const key_type& key) const {
+    const size_type key_hash {hash(key)};
+    const ReadSection section {*this};
+    const Node* node {read_node(key_hash)};
+    const size_type index {node->index_of(key, key_hash, equal)};
+
+    if (index == node->size) return std::nullopt;
+
+    return (*node)[index];
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+bool concurrent_ADS_set<Key, N, Hash, KeyEqual>::contains(const key_type& key) const {
+    const size_type key_hash {hash(key)};
+    const ReadSection section {*this};
+    const Node* node {read_node(key_hash)};
+
+    return node->index_of(key, key_hash, equal) != node->size;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+template<typename Function>
+void concurrent_ADS_set<Key, N, Hash, KeyEqual>::for_each(Function function) {
+    std::lock_guard<std::mutex> lock {split_mutex};
+    const ReadSection section {*this};
+
+    const size_type current_state {state.load(std::memory_order_relaxed)};
+    const size_type split_round {current_state >> split_index_bits};
+    const size_type split_index {current_state & ((size_type {1} << split_index_bits) - 1)};
+
+    for (size_type index {0}; index < (size_type {1} << split_round) + split_index; ++index) {
+        const Node* node {bucket(index).node.load()};
+
+        for (size_type i {0}; i < node->size; ++i) {
+            function((*node)[i]);
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+typename concurrent_ADS_set<Key, N, Hash, KeyEqual>::Node*
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::Node::create(size_type mask, size_type capacity) {
+    void* memory {::operator new(values_offset(capacity) + capacity * sizeof(value_type), alignment())};
+
+    return new (memory) Node {mask, capacity};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+void concurrent_ADS_set<Key, N, Hash, KeyEqual>::Node::destroy(Node* node) {
+    for (size_type i {0}; i < node->size; ++i) {
+        (*node)[i].~value_type();
+    }
+
+    node->~Node();
+    ::operator delete(node, alignment());
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+typename concurrent_ADS_set<Key, N, Hash, KeyEqual>::size_type
+concurrent_ADS_set<Key, N, Hash, KeyEqual>::Node::index_of(const key_type& key, size_type key_hash,
+                                                           const key_equal& equal) const {
+    for (size_type i {0}; i < size; ++i) {
+        if (hashes()[i] == key_hash && equal((*this)[i], key)) return i;
+    }
+
+    return size;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+template<typename... Args>
+void concurrent_ADS_set<Key, N, Hash, KeyEqual>::Node::emplace_back(size_type value_hash, Args&&... args) {
+    unsigned char* values {reinterpret_cast<unsigned char*>(this) + values_offset(capacity)};
+
+    new (values + size * sizeof(value_type)) value_type(std::forward<Args>(args)...);
+    hashes()[size] = value_hash;
+    ++size;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual>
+void concurrent_ADS_set<Key, N, Hash, KeyEqual>::Bucket::lock() {
+    unsigned spins {0};
+
+    while (locked.exchange(true, std::memory_order_acquire)) {
+        // Wait until the lock looks free before trying to take it again
+        while (locked.load(std::memory_order_relaxed)) {
+            if (++spins == spins_before_yield) {
+                spins = 0;
+                std::this_thread::yield();
+            }
+        }
+    }
+}
+
+#endif // CONCURRENT_ADS_SET_H
@@ -0,0 +1,333 @@
+#ifndef MAPPED_ADS_SET_H
+#define MAPPED_ADS_SET_H
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ADS_set.h"
+
+/**
+ * Read-only set answering lookups directly from a file written by ADS_set::save(), which is
+ * mapped into memory instead of being loaded. Pages of the file are only read once lookups
+ * touch them. The template arguments have to match those of the saved set, so keys are hashed
+ * and distributed the same way.
+ *
+ * Keys that are strings are compared by their characters, other keys by the key_equal.
+ *
+ * @tparam Key key type
+ * @tparam N size of the saved set's buckets
+ * @tparam Hash hash function object
+ * @tparam KeyEqual equality function object
+ * @tparam Traits compile-time options, see ADS_set_traits
+ */
+template<typename Key, size_t N = ADS_set_default_bucket_size<Key>::value, typename Hash = std::hash<Key>,
+        typename KeyEqual = std::equal_to<Key>, typename Traits = ADS_set_traits<Key>>
+class mapped_ADS_set {
+public:
+    using value_type = Key;
+    using key_type = Key;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using key_equal = KeyEqual;
+    using hasher = Hash;
+    using set_type = ADS_set<Key, N, Hash, KeyEqual, Traits>;
+private:
+    /** Whether the values are string records */
+    static constexpr bool strings {ADS_set_is_string<key_type>::value};
+
+    /** Start of the mapped file */
+    const unsigned char* mapping {nullptr};
+
+    /** Size of the mapped file */
+    size_type mapping_size {0};
+
+    /** Header of the file */
+    const ADS_set_file_header* header {nullptr};
+
+    /** Offsets of the buckets' first values, followed by the offset of the end */
+    const std::uint64_t* offsets {nullptr};
+
+    /** Start of the values */
+    const unsigned char* values {nullptr};
+
+    /** Hash instance */
+    const hasher hash {};
+
+    /** Key equality instance */
+    const key_equal equal {};
+
+    /**
+     * Get the index of the bucket where a key's value should be at, as the saved set computed it.
+     *
+     * @param key_hash hash of the key
+     * @return index of bucket
+     */
+    size_type bucket_index(size_type key_hash) const;
+
+    /**
+     * Locate the value stored with the given key.
+     *
+     * @param key the key to locate
+     * @return pointer to the key's value or string record; if nothing was found nullptr
+     */
+    const unsigned char* locate(const key_type& key) const;
+
+    /**
+     * Check the header and the checksum and set up the pointers into the mapping. The layout and
+     * the offsets are checked even without the checksum, so lookups never read outside the mapping.
+     *
+     * @param path path of the file, for error messages
+     * @param verify whether the checksum is checked
+     */
+    void attach(const std::string& path, bool verify);
+
+    /**
+     * Unmap the file.
+     */
+    void release();
+
+public:
+    /**
+     * Map a file written by ADS_set::save().
+     *
+     * @param path path of the file
+     * @param verify whether the checksum is checked, which reads the whole file
+     * @throws std::runtime_error if the file can't be mapped or isn't a saved set of this type
+     */
+    explicit mapped_ADS_set(const std::string& path, bool verify = true);
+
+    /**
+     * Unmap the file.
+     */
+    ~mapped_ADS_set() { release(); }
+
+    mapped_ADS_set(const mapped_ADS_set&) = delete;
+
+    mapped_ADS_set& operator=(const mapped_ADS_set&) = delete;
+
+    /**
+     * Creates a set by taking over the mapping of other set.
+     *
+     * @param other other set to move from
+     */
+    mapped_ADS_set(mapped_ADS_set&& other) noexcept;
+
+    /**
+     * Count how many times a key exists in the set (0 or 1).
+     *
+     * @param key the key to count for
+     * @return how many times the key exists (0 or 1)
+     */
+    size_type count(const key_type& key) const { return locate(key) != nullptr; }
+
+    /**
+     * Check whether a key exists in the set.
+     *
+     * @param key the key to check
+     * @return whether the key exists
+     */
+    bool contains(const key_type& key) const { return locate(key) != nullptr; }
+
+    /**
+     * Finds the given key's value in the mapping, which is only available for keys that aren't strings.
+     *
+     * @param key the key to find
+     * @return pointer to the mapped value; if nothing was found nullptr
+     */
+    const value_type* find(const key_type& key) const;
+
+    /**
+     * Get the total amount of stored values.
+     *
+     * @return total amount of stored values
+     */
+    [[nodiscard]] size_type size() const { return header->items_size; }
+
+    /**
+     * Get whether the set is empty.
+     *
+     * @return if set is empty
+     */
+    [[nodiscard]] bool empty() const { return header->items_size == 0; }
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits>
+mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>::mapped_ADS_set(const std::string& path, bool verify) {
+    const int descriptor {::open(path.c_str(), O_RDONLY)};
+
+    if (descriptor < 0) throw std::runtime_error {"mapped_ADS_set: can't open " + path};
+
+    struct stat status {};
+
+    if (::fstat(descriptor, &status) != 0 || static_cast<size_type>(status.st_size) < sizeof(ADS_set_file_header)) {
+        ::close(descriptor);
+        throw std::runtime_error {"mapped_ADS_set: " + path + " is no saved set"};
+    }
+
+    mapping_size = static_cast<size_type>(status.st_size);
+    void* memory {::mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, descriptor, 0)};
+
+    // The mapping stays valid without the descriptor
+    ::close(descriptor);
+
+    if (memory == MAP_FAILED) throw std::runtime_error {"mapped_ADS_set: can't map " + path};
+
+    mapping = static_cast<const unsigned char*>(memory);
+
+    try {
+        attach(path, verify);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits>
+mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>::mapped_ADS_set(mapped_ADS_set&& other) noexcept
+        : mapping {other.mapping}, mapping_size {other.mapping_size}, header {other.header}, offsets {other.offsets},
+          values {other.values}, hash {other.hash}, equal {other.equal} {
+    other.mapping = nullptr;
+    other.mapping_size = 0;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits>
+void mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>::attach(const std::string& path, bool verify) {
+    header = reinterpret_cast<const ADS_set_file_header*>(mapping);
+
+    const bool matches {std::memcmp(header->magic, ADS_set_file_header::file_magic, sizeof(header->magic)) == 0 &&
+                        header->version == ADS_set_file_header::file_version &&
+                        header->strings == static_cast<std::uint32_t>(strings) &&
+                        header->mixer == static_cast<std::uint32_t>(Traits::mixer) &&
+                        header->hash_size == sizeof(size_type) &&
+                        header->body_size == mapping_size - sizeof(ADS_set_file_header)};
+
+    if (!matches) throw std::runtime_error {"mapped_ADS_set: " + path + " is no saved set of this type"};
+
+    if constexpr (strings) {
+        if (header->key_size != sizeof(typename key_type::value_type)) {
+            throw std::runtime_error {"mapped_ADS_set: " + path + " holds other characters"};
+        }
+    } else if (header->key_size != sizeof(key_type)) {
+        throw std::runtime_error {"mapped_ADS_set: " + path + " holds other keys"};
+    }
+
+    const unsigned char* body {mapping + sizeof(ADS_set_file_header)};
+
+    if (verify && header->file_checksum(ADS_set_file_header::checksum_of(ADS_set_file_header::checksum_seed, body,
+                                                                          header->body_size)) != header->checksum) {
+        throw std::runtime_error {"mapped_ADS_set: checksum of " + path + " doesn't match"};
+    }
+
+    // The layout selects the offsets lookups read, the offsets have to fit the body
+    const std::uint64_t split_round {header->split_round};
+    const bool consistent {split_round < sizeof(size_type) * CHAR_BIT - 1 &&
+                           header->table_split_index < (std::uint64_t {1} << split_round) &&
+                           header->bucket_count == (std::uint64_t {1} << split_round) + header->table_split_index &&
+                           header->bucket_count < header->body_size / sizeof(std::uint64_t)};
+
+    if (!consistent) throw std::runtime_error {"mapped_ADS_set: layout of " + path + " is malformed"};
+
+    const size_type bucket_count {static_cast<size_type>(header->bucket_count)};
+    size_type values_offset {sizeof(ADS_set_file_header) + (bucket_count + 1) * sizeof(std::uint64_t)};
+
+    if constexpr (!strings) {
+        // Skip the padding that aligns the values relative to the start of the file
+        constexpr size_type alignment {alignof(key_type) > 8 ? alignof(key_type) : 8};
+        values_offset = (values_offset + alignment - 1) / alignment * alignment;
+    }
+
+    if (values_offset > mapping_size) throw std::runtime_error {"mapped_ADS_set: layout of " + path + " is malformed"};
+
+    offsets = reinterpret_cast<const std::uint64_t*>(body);
+    values = mapping + values_offset;
+
+    // Offsets count values for keys and bytes for strings, they never decrease and end in the body
+    const size_type capacity {(mapping_size - values_offset) / (strings ? 1 : sizeof(key_type))};
+
+    bool ordered {offsets[bucket_count] <= capacity};
+
+    for (size_type i {0}; ordered && i < bucket_count; ++i) {
+        ordered = offsets[i] <= offsets[i + 1];
+    }
+
+    if (!ordered) throw std::runtime_error {"mapped_ADS_set: offsets of " + path + " are malformed"};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits>
+void mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>::release() {
+    if (mapping != nullptr) {
+        ::munmap(const_cast<unsigned char*>(mapping), mapping_size);
+        mapping = nullptr;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits>
+typename mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>::size_type
+mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>::bucket_index(size_type key_hash) const {
+    const size_type split_round {static_cast<size_type>(header->split_round)};
+    size_type index {key_hash & ((size_type {1} << split_round) - 1)};
+
+    // Use next split round's hash function for already split buckets
+    if (index < header->table_split_index) {
+        index = key_hash & ((size_type {2} << split_round) - 1);
+    }
+
+    return index;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits>
+const unsigned char* mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>::locate(const key_type& key) const {
+    const size_type key_hash {set_type::mix(hash(key))};
+    const size_type index {bucket_index(key_hash)};
+
+    if constexpr (strings) {
+        using char_type = typename key_type::value_type;
+
+        const unsigned char* record {values + offsets[index]};
+        const unsigned char* end {values + offsets[index + 1]};
+
+        // Walk the records, comparing hashes and lengths before the characters. Records are only
+        // covered by the checksum, so their lengths are checked against the end of the bucket.
+        while (end - record >= static_cast<std::ptrdiff_t>(2 * sizeof(std::uint64_t))) {
+            std::uint64_t fields[2];
+            std::memcpy(fields, record, sizeof(fields));
+
+            if (fields[1] > (static_cast<size_type>(end - record) - sizeof(fields)) / sizeof(char_type)) break;
+
+            if (fields[0] == key_hash && fields[1] == key.size() &&
+                std::char_traits<char_type>::compare(reinterpret_cast<const char_type*>(record + sizeof(fields)),
+                                                     key.data(), key.size()) == 0) {
+                return record;
+            }
+
+            record += (sizeof(fields) + fields[1] * sizeof(char_type) + 7) / 8 * 8;
+        }
+    } else {
+        const auto* keys {reinterpret_cast<const value_type*>(values)};
+
+        for (size_type i {offsets[index]}; i < offsets[index + 1]; ++i) {
+            if (equal(keys[i], key)) return reinterpret_cast<const unsigned char*>(keys + i);
+        }
+    }
+
+    return nullptr;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits>
+const typename mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>::value_type*
+mapped_ADS_set<Key, N, Hash, KeyEqual, Traits>::find(const key_type& key) const {
+    static_assert(!strings, "find is only available for keys that aren't strings");
+
+    return reinterpret_cast<const value_type*>(locate(key));
+}
+
+#endif // MAPPED_ADS_SET_H
@@ -0,0 +1,1031 @@
+/**
+ * Benchmark suite of ADS_set, built by the perftest target.
+ *
+ * Every case builds one container from one key type and key distribution and runs one workload
+ * on it. Cases run in forked child processes, so the peak resident set size reported for a case
+ * is its own. Results are printed as JSON to stdout, progress goes to stderr.
+ *
+ * Usage: perftest [--size n] [--repeat r] [--threads t] [--filter text] [--quick] [--list]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ADS_set.h"
+#include "concurrent_ADS_set.h"
+#include "sharded_ADS_set.h"
+
+/**
+ * Key with several members, hashed and compared by all of them.
+ */
+struct Person {
+    std::string first_name;
+    std::string last_name;
+    unsigned age {0};
+
+    bool operator==(const Person& other) const {
+        return age == other.age && first_name == other.first_name && last_name == other.last_name;
+    }
+};
+
+std::ostream& operator<<(std::ostream& o, const Person& person) {
+    return o << person.first_name << ' ' << person.last_name << " (" << person.age << ')';
+}
+
+namespace std {
+template<>
+struct hash<Person> {
+    size_t operator()(const Person& person) const {
+        size_t key_hash {hash<string> {}(person.first_name)};
+
+        key_hash = key_hash * 31 + hash<string> {}(person.last_name);
+
+        return key_hash * 31 + person.age;
+    }
+};
+}
+
+/**
+ * Traits enabling the hash mixer, for keys whose hash is the identity.
+ */
+struct mixed_traits : ADS_set_traits<unsigned> {
+    static constexpr ADS_set_mixer mixer {ADS_set_mixer::fmix};
+};
+
+/**
+ * Traits spreading every split over the following inserts and erases, which bounds their latency.
+ */
+struct incremental_traits : ADS_set_traits<unsigned> {
+    static constexpr size_t split_budget {16};
+};
+
+/**
+ * Traits adding the per-bucket signatures that answer most lookups of missing keys.
+ */
+struct prefiltered_traits : ADS_set_traits<unsigned> {
+    static constexpr bool prefilter {true};
+};
+
+/**
+ * Open addressing baseline with linear probing over a power-of-two table, which is kept at most
+ * half full including erased slots. Hashes are mixed, as open addressing relies on their low bits.
+ *
+ * @tparam Key key type
+ * @tparam Hash hash function object
+ */
+template<typename Key, typename Hash = std::hash<Key>>
+class open_addressing_set {
+public:
+    using key_type = Key;
+private:
+    /** States of a slot */
+    enum : unsigned char { empty, full, erased };
+
+    /** Key per slot, default constructed in unused slots */
+    std::vector<Key> keys;
+
+    /** State per slot */
+    std::vector<unsigned char> states;
+
+    /** Amount of full slots */
+    size_t items_size {0};
+
+    /** Amount of full and erased slots */
+    size_t used_size {0};
+
+    /** Hash instance */
+    Hash hash {};
+
+    /**
+     * Get the slot where probing for a key starts.
+     *
+     * @param key the key
+     * @return index of slot
+     */
+    size_t home(const Key& key) const {
+        std::uint64_t key_hash {hash(key)};
+
+        key_hash ^= key_hash >> 33;
+        key_hash *= 0xFF51AFD7ED558CCDull;
+        key_hash ^= key_hash >> 33;
+
+        return static_cast<size_t>(key_hash) & (states.size() - 1);
+    }
+
+    /**
+     * Move all keys to a table of the given size, dropping erased slots.
+     *
+     * @param capacity amount of slots, a power of two
+     */
+    void rehash(size_t capacity) {
+        std::vector<Key> old_keys(capacity);
+        std::vector<unsigned char> old_states(capacity, empty);
+
+        old_keys.swap(keys);
+        old_states.swap(states);
+        used_size = items_size;
+
+        for (size_t i {0}; i < old_states.size(); ++i) {
+            if (old_states[i] != full) continue;
+
+            size_t slot {home(old_keys[i])};
+
+            while (states[slot] != empty) slot = (slot + 1) & (states.size() - 1);
+
+            keys[slot] = std::move(old_keys[i]);
+            states[slot] = full;
+        }
+    }
+
+public:
+    open_addressing_set() : keys(16), states(16, empty) {}
+
+    template<typename InputIt>
+    open_addressing_set(InputIt first, InputIt last) : open_addressing_set {} {
+        for (; first != last; ++first) insert(*first);
+    }
+
+    bool insert(const Key& key) {
+        if ((used_size + 1) * 2 > states.size()) rehash(items_size * 4 > states.size() ? states.size() * 2 : states.size());
+
+        size_t slot {home(key)};
+        size_t reuse {states.size()};
+
+        for (; states[slot] != empty; slot = (slot + 1) & (states.size() - 1)) {
+            if (states[slot] == full && keys[slot] == key) return false;
+            if (states[slot] == erased && reuse == states.size()) reuse = slot;
+        }
+
+        if (reuse != states.size()) {
+            slot = reuse;
+        } else {
+            ++used_size;
+        }
+
+        keys[slot] = key;
+        states[slot] = full;
+        ++items_size;
+
+        return true;
+    }
+
+    size_t count(const Key& key) const {
+        for (size_t slot {home(key)}; states[slot] != empty; slot = (slot + 1) & (states.size() - 1)) {
+            if (states[slot] == full && keys[slot] == key) return 1;
+        }
+
+        return 0;
+    }
+
+    size_t erase(const Key& key) {
+        for (size_t slot {home(key)}; states[slot] != empty; slot = (slot + 1) & (states.size() - 1)) {
+            if (states[slot] == full && keys[slot] == key) {
+                states[slot] = erased;
+                keys[slot] = Key {};
+                --items_size;
+
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    template<typename Function>
+    void for_each(Function function) const {
+        for (size_t i {0}; i < states.size(); ++i) {
+            if (states[i] == full) function(keys[i]);
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return items_size; }
+};
+
+/**
+ * ADS_set behind one mutex, the baseline of the concurrent sets.
+ *
+ * @tparam Set type of set
+ */
+template<typename Set>
+class locked_set {
+public:
+    using key_type = typename Set::key_type;
+private:
+    mutable std::mutex mutex;
+    Set set;
+
+public:
+    bool insert(const typename Set::key_type& key) {
+        std::lock_guard<std::mutex> lock {mutex};
+
+        return set.insert(key).second;
+    }
+
+    size_t count(const typename Set::key_type& key) const {
+        std::lock_guard<std::mutex> lock {mutex};
+
+        return set.count(key);
+    }
+
+    [[nodiscard]] size_t size() const {
+        std::lock_guard<std::mutex> lock {mutex};
+
+        return set.size();
+    }
+};
+
+/** Results of lookups are added to it, so they can't be optimized away */
+volatile size_t sink {0};
+
+/**
+ * End the case as failed if a result isn't the expected one, so a broken container can't report
+ * good numbers.
+ *
+ * @param condition whether the result is as expected
+ * @param what description of the result
+ */
+void expect(bool condition, const char* what) {
+    if (condition) return;
+
+    std::fprintf(stderr, "unexpected result: %s\n", what);
+    _exit(1);
+}
+
+/**
+ * Options given on the command line.
+ */
+struct Options {
+    /** Amount of keys per case */
+    size_t size {size_t {1} << 18};
+
+    /** How many times each case is measured */
+    size_t repeat {3};
+
+    /** Maximum amount of threads of the concurrent workloads */
+    size_t threads {std::max<size_t>(1, std::thread::hardware_concurrency())};
+
+    /** Only cases whose name contains it are run */
+    std::string filter;
+
+    /** Whether the names of the cases are printed instead of running them */
+    bool list {false};
+};
+
+/**
+ * Distributions of the keys and of the accesses to them.
+ */
+enum class Distribution {
+    /** Keys are spread over the whole key range, accesses are in random order */
+    uniform,
+
+    /** Keys are consecutive, accesses are in random order */
+    sequential,
+
+    /** Keys are multiples of a power of two, accesses are in random order */
+    strided,
+
+    /** Keys are uniform, accesses follow Zipf's law with exponent 0.99 */
+    zipfian
+};
+
+const char* name_of(Distribution distribution) {
+    switch (distribution) {
+        case Distribution::uniform:
+            return "uniform";
+        case Distribution::sequential:
+            return "sequential";
+        case Distribution::strided:
+            return "strided";
+        default:
+            return "zipfian";
+    }
+}
+
+/** Distance of strided keys */
+constexpr std::uint64_t key_stride {64};
+
+/**
+ * Get the number of the i-th key of a distribution. Numbers are distinct for distinct i.
+ *
+ * @param distribution the distribution
+ * @param i index of key
+ * @return number of the key
+ */
+std::uint64_t key_number(Distribution distribution, std::uint64_t i) {
+    switch (distribution) {
+        case Distribution::sequential:
+            return i;
+        case Distribution::strided:
+            return i * key_stride;
+        default: {
+            // The finalizer of MurmurHash3 is a bijection of 32-bit numbers
+            auto number {static_cast<std::uint32_t>(i)};
+
+            number ^= number >> 16;
+            number *= 0x85EBCA6Bu;
+            number ^= number >> 13;
+            number *= 0xC2B2AE35u;
+            number ^= number >> 16;
+
+            return number;
+        }
+    }
+}
+
+template<typename Key>
+Key make_key(std::uint64_t number);
+
+template<>
+unsigned make_key<unsigned>(std::uint64_t number) { return static_cast<unsigned>(number); }
+
+template<>
+std::string make_key<std::string>(std::uint64_t number) { return "key-" + std::to_string(number); }
+
+template<>
+Person make_key<Person>(std::uint64_t number) {
+    return {"first-" + std::to_string(number), "last-" + std::to_string(number % 1000),
+            static_cast<unsigned>(number % 100)};
+}
+
+/**
+ * Draws indices in [0, n) following Zipf's law, index 0 being the most frequent one
+ * (Gray et al., Quickly generating billion-record synthetic databases).
+ */
+class zipf_distribution {
+    static constexpr double theta {0.99};
+
+    size_t n;
+    double alpha;
+    double zeta_n;
+    double eta;
+
+public:
+    explicit zipf_distribution(size_t n) : n {n}, alpha {1 / (1 - theta)}, zeta_n {0} {
+        for (size_t i {1}; i <= n; ++i) zeta_n += 1 / std::pow(static_cast<double>(i), theta);
+
+        const double zeta_2 {1 + 1 / std::pow(2.0, theta)};
+        eta = (1 - std::pow(2.0 / static_cast<double>(n), 1 - theta)) / (1 - zeta_2 / zeta_n);
+    }
+
+    template<typename Generator>
+    size_t operator()(Generator& generator) {
+        const double u {std::uniform_real_distribution<double> {0, 1}(generator)};
+        const double uz {u * zeta_n};
+
+        if (uz < 1) return 0;
+        if (uz < 1 + std::pow(0.5, theta)) return 1 < n ? 1 : 0;
+
+        const auto index {static_cast<size_t>(static_cast<double>(n) * std::pow(eta * u - eta + 1, alpha))};
+
+        return index < n ? index : n - 1;
+    }
+};
+
+/**
+ * Keys of a case and the order they are accessed in.
+ *
+ * @tparam Key key type
+ */
+template<typename Key>
+struct Input {
+    /** Keys inserted into the container */
+    std::vector<Key> keys;
+
+    /** Keys never inserted, looked up by the miss workload and inserted by the churn workload */
+    std::vector<Key> misses;
+
+    /** Indices of the keys inserted by the insert workload */
+    std::vector<size_t> insert_order;
+
+    /** Indices of the keys accessed by the lookup and churn workloads */
+    std::vector<size_t> access_order;
+
+    /** Amount of distinct keys inserted by the insert workload */
+    size_t inserted_size {0};
+
+    Input(Distribution distribution, size_t size) {
+        std::mt19937_64 generator {42};
+
+        keys.reserve(size);
+        misses.reserve(size);
+
+        for (size_t i {0}; i < size; ++i) {
+            keys.push_back(make_key<Key>(key_number(distribution, i)));
+            misses.push_back(make_key<Key>(key_number(distribution, size + i)));
+        }
+
+        insert_order.resize(size);
+        access_order.resize(size);
+
+        if (distribution == Distribution::zipfian) {
+            zipf_distribution zipf {size};
+
+            std::vector<bool> drawn(size);
+
+            for (size_t i {0}; i < size; ++i) {
+                insert_order[i] = zipf(generator);
+                access_order[i] = zipf(generator);
+                inserted_size += !drawn[insert_order[i]];
+                drawn[insert_order[i]] = true;
+            }
+        } else {
+            inserted_size = size;
+
+            for (size_t i {0}; i < size; ++i) insert_order[i] = access_order[i] = i;
+
+            std::shuffle(access_order.begin(), access_order.end(), generator);
+        }
+    }
+};
+
+/**
+ * Collects the timings of a case. Throughput is taken over whole runs of operations, latency
+ * from every sample_interval-th operation timed on its own, so a single slow operation shows
+ * in the percentiles instead of being averaged with its neighbours.
+ */
+class Recorder {
+    /** Nanoseconds of each sampled operation */
+    std::vector<double> latencies;
+
+    /** Elements per second of each repetition */
+    std::vector<double> throughputs;
+
+    /** Elements processed by the current repetition */
+    size_t elements {0};
+
+    /** Seconds spent by the current repetition */
+    double seconds {0};
+
+public:
+    /**
+     * Operations between two sampled ones. Each sample reads the clock twice, which adds a few
+     * nanoseconds per 16 operations to the throughput.
+     */
+    static constexpr size_t sample_interval {16};
+
+    /**
+     * Time work processing many elements at once for the throughput, without latency samples.
+     *
+     * @tparam Function type of function
+     * @param count amount of elements the work processes
+     * @param function the work
+     */
+    template<typename Function>
+    void time(size_t count, Function function) {
+        const auto start {std::chrono::steady_clock::now()};
+        function();
+        const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+
+        elements += count;
+        seconds += elapsed.count();
+    }
+
+    /**
+     * Run a given amount of operations, timing every sample_interval-th one on its own.
+     *
+     * @tparam Operation type of function
+     * @param begin index of the first operation
+     * @param end index behind the last operation
+     * @param operation function running the operation with a given index
+     */
+    template<typename Operation>
+    void run(size_t begin, size_t end, Operation operation) {
+        const auto start {std::chrono::steady_clock::now()};
+
+        for (size_t i {begin}; i < end; ++i) {
+            if (i % sample_interval != 0) {
+                operation(i);
+                continue;
+            }
+
+            const auto before {std::chrono::steady_clock::now()};
+            operation(i);
+            const std::chrono::duration<double, std::nano> latency {std::chrono::steady_clock::now() - before};
+
+            latencies.push_back(latency.count());
+        }
+
+        const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+
+        elements += end - begin;
+        seconds += elapsed.count();
+    }
+
+    /**
+     * Add the latency samples of another recorder, without its repetitions.
+     *
+     * @param other the recorder
+     */
+    void add(const Recorder& other) {
+        latencies.insert(latencies.end(), other.latencies.begin(), other.latencies.end());
+    }
+
+    /**
+     * End a repetition, whose throughput is its elements over the given wall time.
+     *
+     * @param count amount of elements processed
+     * @param wall_seconds wall time of the repetition; if 0 the time of its runs
+     */
+    void finish_repetition(size_t count = 0, double wall_seconds = 0) {
+        if (count == 0) count = elements;
+        if (wall_seconds == 0) wall_seconds = seconds;
+        if (wall_seconds > 0) throughputs.push_back(static_cast<double>(count) / wall_seconds);
+
+        elements = 0;
+        seconds = 0;
+    }
+
+    /**
+     * Print the measurements as JSON members. Workloads without single operations, like copies,
+     * have no latency samples.
+     */
+    void print() {
+        std::sort(latencies.begin(), latencies.end());
+        std::sort(throughputs.begin(), throughputs.end());
+
+        const auto percentile = [&](double p) {
+            return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * static_cast<double>(latencies.size())))];
+        };
+
+        std::printf("\"throughput\": %.1f, \"throughput_min\": %.1f, \"throughput_max\": %.1f, ",
+                    throughputs.empty() ? 0.0 : throughputs[throughputs.size() / 2],
+                    throughputs.empty() ? 0.0 : throughputs.front(), throughputs.empty() ? 0.0 : throughputs.back());
+        if (latencies.empty()) {
+            std::printf("\"latency_samples\": 0, \"latency_ns\": null");
+            return;
+        }
+
+        std::printf("\"latency_samples\": %zu, \"latency_ns\": {\"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, "
+                    "\"p999\": %.2f, \"p9999\": %.2f, \"max\": %.2f}", latencies.size(), percentile(0.5),
+                    percentile(0.9), percentile(0.99), percentile(0.999), percentile(0.9999), latencies.back());
+    }
+};
+
+template<typename Set>
+bool insert_key(Set& set, const typename Set::key_type& key) { return set.insert(key).second; }
+
+template<typename Key, typename Hash>
+bool insert_key(open_addressing_set<Key, Hash>& set, const Key& key) { return set.insert(key); }
+
+template<typename Set, typename Function>
+void visit_all(const Set& set, Function function) {
+    for (const auto& key : set) function(key);
+}
+
+template<typename Key, typename Hash, typename Function>
+void visit_all(const open_addressing_set<Key, Hash>& set, Function function) { set.for_each(function); }
+
+/**
+ * Workloads of the single-threaded containers.
+ */
+enum class Workload {
+    insert,
+    lookup_hit,
+    lookup_miss,
+    erase_churn,
+    iteration,
+    copy,
+    bulk_build
+};
+
+const char* name_of(Workload workload) {
+    switch (workload) {
+        case Workload::insert:
+            return "insert";
+        case Workload::lookup_hit:
+            return "lookup_hit";
+        case Workload::lookup_miss:
+            return "lookup_miss";
+        case Workload::erase_churn:
+            return "erase_churn";
+        case Workload::iteration:
+            return "iteration";
+        case Workload::copy:
+            return "copy";
+        default:
+            return "bulk_build";
+    }
+}
+
+/**
+ * Run one repetition of a workload.
+ *
+ * @tparam Set type of container
+ * @tparam Key key type
+ * @param workload the workload
+ * @param input keys of the case
+ * @param recorder receives the timings
+ */
+template<typename Set, typename Key>
+void run_workload(Workload workload, const Input<Key>& input, Recorder& recorder) {
+    const size_t size {input.keys.size()};
+
+    if (workload == Workload::insert) {
+        Set set;
+        size_t inserted {0};
+
+        recorder.run(0, size, [&](size_t i) { inserted += insert_key(set, input.keys[input.insert_order[i]]); });
+
+        expect(inserted == input.inserted_size && set.size() == input.inserted_size, "inserted keys");
+        sink = sink + set.size();
+    } else if (workload == Workload::bulk_build) {
+        std::optional<Set> set;
+
+        recorder.time(size, [&] { set.emplace(input.keys.begin(), input.keys.end()); });
+        expect(set->size() == size, "built keys");
+        sink = sink + set->size();
+    } else {
+        Set set(input.keys.begin(), input.keys.end());
+
+        expect(set.size() == size, "built keys");
+
+        if (workload == Workload::lookup_hit || workload == Workload::lookup_miss) {
+            const bool hits {workload == Workload::lookup_hit};
+            const std::vector<Key>& keys {hits ? input.keys : input.misses};
+            size_t found {0};
+
+            recorder.run(0, size, [&](size_t i) { found += set.count(keys[input.access_order[i]]); });
+
+            expect(found == (hits ? size : 0), hits ? "lookup hits" : "lookup misses");
+            sink = sink + found;
+        } else if (workload == Workload::erase_churn) {
+            // Every operation replaces a key by one that isn't in the set, so the size stays the same
+            std::vector<Key> live {input.keys};
+            std::vector<Key> spare {input.misses};
+            size_t replaced {0};
+
+            recorder.run(0, size, [&](size_t i) {
+                const size_t index {input.access_order[i]};
+
+                const bool erased {set.erase(live[index]) == 1};
+                const bool inserted {insert_key(set, spare[index])};
+
+                replaced += erased && inserted;
+                std::swap(live[index], spare[index]);
+            });
+
+            expect(replaced == size && set.size() == size, "replaced keys");
+
+            for (const Key& key : live) expect(set.count(key) == 1, "keys after churn");
+
+            sink = sink + set.size();
+        } else if (workload == Workload::iteration) {
+            size_t visited {0};
+
+            for (size_t pass {0}; pass < 8; ++pass) {
+                recorder.time(set.size(), [&] { visit_all(set, [&](const Key&) { ++visited; }); });
+            }
+
+            expect(visited == 8 * size, "visited keys");
+            sink = sink + visited;
+        } else {
+            std::optional<Set> copy;
+
+            for (size_t pass {0}; pass < 4; ++pass) {
+                recorder.time(size, [&] { copy.emplace(set); });
+                expect(copy->size() == size, "copied keys");
+                sink = sink + copy->size();
+                copy.reset();
+            }
+        }
+    }
+
+    recorder.finish_repetition();
+}
+
+/**
+ * Workloads of the concurrent containers.
+ */
+enum class ConcurrentWorkload {
+    /** Threads insert disjoint slices of the keys into an empty set */
+    insert,
+
+    /** Threads look up the keys of a built set */
+    lookup,
+
+    /** Threads look up keys of a built set and insert one new key per 10 operations */
+    mixed
+};
+
+const char* name_of(ConcurrentWorkload workload) {
+    switch (workload) {
+        case ConcurrentWorkload::insert:
+            return "concurrent_insert";
+        case ConcurrentWorkload::lookup:
+            return "concurrent_lookup";
+        default:
+            return "concurrent_mixed";
+    }
+}
+
+/**
+ * Run one repetition of a concurrent workload.
+ *
+ * @tparam Set type of container
+ * @tparam Key key type
+ * @param workload the workload
+ * @param threads amount of threads
+ * @param input keys of the case
+ * @param recorder receives the timings
+ */
+template<typename Set, typename Key>
+void run_concurrent_workload(ConcurrentWorkload workload, size_t threads, const Input<Key>& input, Recorder& recorder) {
+    const size_t size {input.keys.size()};
+    Set set;
+
+    if (workload != ConcurrentWorkload::insert) {
+        for (const Key& key : input.keys) set.insert(key);
+    }
+
+    std::vector<Recorder> recorders(threads);
+    std::vector<size_t> found(threads);
+    std::vector<std::thread> workers;
+
+    // Every operation succeeds: inserts add distinct new keys and lookups look up inserted keys
+    const auto work = [&](size_t thread) {
+        size_t thread_found {0};
+
+        recorders[thread].run(size * thread / threads, size * (thread + 1) / threads, [&](size_t i) {
+            if (workload == ConcurrentWorkload::insert) {
+                thread_found += set.insert(input.keys[i]);
+            } else if (workload == ConcurrentWorkload::mixed && i % 10 == 0) {
+                thread_found += set.insert(input.misses[i]);
+            } else {
+                thread_found += set.count(input.keys[input.access_order[i]]);
+            }
+        });
+
+        found[thread] = thread_found;
+    };
+
+    const auto start {std::chrono::steady_clock::now()};
+
+    for (size_t thread {1}; thread < threads; ++thread) workers.emplace_back(work, thread);
+
+    work(0);
+
+    for (std::thread& worker : workers) worker.join();
+
+    const std::chrono::duration<double> elapsed {std::chrono::steady_clock::now() - start};
+
+    for (const Recorder& thread_recorder : recorders) recorder.add(thread_recorder);
+
+    recorder.finish_repetition(size, elapsed.count());
+
+    size_t succeeded {0};
+
+    for (size_t thread_found : found) succeeded += thread_found;
+
+    expect(succeeded == size, "successful operations");
+    expect(set.size() == (workload == ConcurrentWorkload::mixed ? size + (size + 9) / 10 : size), "final keys");
+    sink = sink + set.size();
+}
+
+/**
+ * Get the peak resident set size of the process.
+ *
+ * @return peak resident set size in KiB
+ */
+long peak_rss_kb() {
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+}
+
+/**
+ * A benchmark case, run in a child process.
+ */
+struct Case {
+    std::string name;
+    std::string container;
+    std::string key;
+    Distribution distribution;
+    std::string workload;
+    size_t threads;
+    std::function<void(const Options&)> run;
+};
+
+/**
+ * Print the members describing a case and its peak memory.
+ */
+void print_case(const Case& current, const Options& options, long baseline_rss_kb) {
+    std::printf("    {\"name\": \"%s\", \"container\": \"%s\", \"key\": \"%s\", \"distribution\": \"%s\", "
+                "\"workload\": \"%s\", \"threads\": %zu, \"size\": %zu, \"repeat\": %zu, "
+                "\"baseline_rss_kb\": %ld, \"peak_rss_kb\": %ld, ",
+                current.name.c_str(), current.container.c_str(), current.key.c_str(), name_of(current.distribution),
+                current.workload.c_str(), current.threads, options.size, options.repeat, baseline_rss_kb, peak_rss_kb());
+}
+
+/** Cases of the suite */
+std::vector<Case> cases;
+
+/**
+ * Add the single-threaded cases of a container.
+ *
+ * @tparam Set type of container
+ * @param container name of the container
+ * @param key name of the key type
+ */
+template<typename Set>
+void add_cases(const std::string& container, const std::string& key) {
+    using key_type = typename Set::key_type;
+
+    for (Distribution distribution : {Distribution::uniform, Distribution::sequential, Distribution::strided,
+                                      Distribution::zipfian}) {
+        for (Workload workload : {Workload::insert, Workload::lookup_hit, Workload::lookup_miss, Workload::erase_churn,
+                                  Workload::iteration, Workload::copy, Workload::bulk_build}) {
+            Case current {container + "/" + key + "/" + name_of(distribution) + "/" + name_of(workload), container, key,
+                          distribution, name_of(workload), 1, {}};
+
+            current.run = [current, distribution, workload](const Options& options) {
+                const Input<key_type> input {distribution, options.size};
+                const long baseline {peak_rss_kb()};
+                Recorder recorder;
+
+                for (size_t repetition {0}; repetition < options.repeat; ++repetition) {
+                    run_workload<Set>(workload, input, recorder);
+                }
+
+                print_case(current, options, baseline);
+                recorder.print();
+            };
+
+            cases.push_back(std::move(current));
+        }
+    }
+}
+
+/**
+ * Add the concurrent cases of a container, for 1, 2, 4, ... threads up to the maximum.
+ *
+ * @tparam Set type of container
+ * @param container name of the container
+ * @param max_threads maximum amount of threads
+ */
+template<typename Set>
+void add_concurrent_cases(const std::string& container, size_t max_threads) {
+    for (Distribution distribution : {Distribution::uniform, Distribution::zipfian}) {
+        for (ConcurrentWorkload workload : {ConcurrentWorkload::insert, ConcurrentWorkload::lookup,
+                                            ConcurrentWorkload::mixed}) {
+            for (size_t threads {1}; threads <= max_threads; threads = threads * 2 > max_threads && threads < max_threads
+                                                                            ? max_threads : threads * 2) {
+                Case current {container + "/unsigned/" + name_of(distribution) + "/" + name_of(workload) + "/" +
+                              std::to_string(threads), container, "unsigned", distribution, name_of(workload), threads, {}};
+
+                current.run = [current, distribution, workload, threads](const Options& options) {
+                    const Input<unsigned> input {distribution, options.size};
+                    const long baseline {peak_rss_kb()};
+                    Recorder recorder;
+
+                    for (size_t repetition {0}; repetition < options.repeat; ++repetition) {
+                        run_concurrent_workload<Set>(workload, threads, input, recorder);
+                    }
+
+                    print_case(current, options, baseline);
+                    recorder.print();
+                };
+
+                cases.push_back(std::move(current));
+            }
+        }
+    }
+}
+
+/**
+ * Add the single-threaded cases of all containers for a key type.
+ *
+ * @tparam Key key type
+ * @param key name of the key type
+ */
+template<typename Key>
+void add_key_cases(const std::string& key) {
+    add_cases<ADS_set<Key, 1>>("ADS_set<N=1>", key);
+    add_cases<ADS_set<Key, 5>>("ADS_set<N=5>", key);
+    add_cases<ADS_set<Key, 16>>("ADS_set<N=16>", key);
+    add_cases<ADS_set<Key, 64>>("ADS_set<N=64>", key);
+    add_cases<ADS_set<Key>>("ADS_set<N=default=" + std::to_string(ADS_set_default_bucket_size<Key>::value) + ">", key);
+    add_cases<std::unordered_set<Key>>("std::unordered_set", key);
+    add_cases<open_addressing_set<Key>>("open_addressing_set", key);
+}
+
+/**
+ * Parse the command line.
+ *
+ * @return the options; exits on invalid arguments
+ */
+Options parse_options(int argc, char** argv) {
+    Options options;
+
+    for (int i {1}; i < argc; ++i) {
+        const std::string argument {argv[i]};
+        const bool has_value {i + 1 < argc};
+
+        if (argument == "--size" && has_value) {
+            options.size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--repeat" && has_value) {
+            options.repeat = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--threads" && has_value) {
+            options.threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument == "--filter" && has_value) {
+            options.filter = argv[++i];
+        } else if (argument == "--quick") {
+            options.size = size_t {1} << 14;
+            options.repeat = 1;
+        } else if (argument == "--list") {
+            options.list = true;
+        } else {
+            std::fprintf(stderr, "usage: %s [--size n] [--repeat r] [--threads t] [--filter text] [--quick] [--list]\n",
+                         argv[0]);
+            std::exit(2);
+        }
+    }
+
+    if (options.size == 0 || options.repeat == 0 || options.threads == 0) {
+        std::fprintf(stderr, "%s: size, repeat and threads have to be positive\n", argv[0]);
+        std::exit(2);
+    }
+
+    return options;
+}
+
+int main(int argc, char** argv) {
+    const Options options {parse_options(argc, argv)};
+
+    add_key_cases<unsigned>("unsigned");
+    add_cases<ADS_set<unsigned, 5, std::hash<unsigned>, std::equal_to<unsigned>, mixed_traits>>("ADS_set<N=5,fmix>",
+                                                                                                 "unsigned");
+    add_cases<ADS_set<unsigned, ADS_set_default_bucket_size<unsigned>::value, std::hash<unsigned>, std::equal_to<unsigned>,
+                      incremental_traits>>("ADS_set<N=default=" + std::to_string(ADS_set_default_bucket_size<unsigned>::value) +
+                                           ",split_budget=16>", "unsigned");
+    add_cases<ADS_set<unsigned, ADS_set_default_bucket_size<unsigned>::value, std::hash<unsigned>, std::equal_to<unsigned>,
+                      prefiltered_traits>>("ADS_set<N=default=" + std::to_string(ADS_set_default_bucket_size<unsigned>::value) +
+                                           ",prefilter>", "unsigned");
+    add_key_cases<std::string>("std::string");
+    add_key_cases<Person>("Person");
+
+    add_concurrent_cases<concurrent_ADS_set<unsigned>>("concurrent_ADS_set", options.threads);
+    add_concurrent_cases<sharded_ADS_set<unsigned>>("sharded_ADS_set", options.threads);
+    add_concurrent_cases<locked_set<ADS_set<unsigned>>>("locked_ADS_set", options.threads);
+
+    if (options.list) {
+        for (const Case& current : cases) {
+            if (current.name.find(options.filter) != std::string::npos) std::printf("%s\n", current.name.c_str());
+        }
+
+        return 0;
+    }
+
+    std::printf("{\n  \"suite\": \"ADS_set\",\n  \"config\": {\"size\": %zu, \"repeat\": %zu, \"threads\": %zu, "
+                "\"compiler\": \"%s\"},\n  \"results\": [\n", options.size, options.repeat, options.threads, __VERSION__);
+
+    bool first {true};
+    int failures {0};
+
+    for (const Case& current : cases) {
+        if (current.name.find(options.filter) == std::string::npos) continue;
+
+        std::fprintf(stderr, "%s\n", current.name.c_str());
+        std::printf("%s", first ? "" : ",\n");
+        std::fflush(stdout);
+        first = false;
+
+        // Run every case in its own process, so its peak memory isn't mixed up with other cases
+        const pid_t child {fork()};
+
+        if (child == 0) {
+            current.run(options);
+            std::printf("}");
+            std::fflush(stdout);
+            _exit(0);
+        }
+
+        int status {0};
+
+        if (child < 0 || waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::printf("    {\"name\": \"%s\", \"error\": \"case failed\"}", current.name.c_str());
+            ++failures;
+        }
+    }
+
+    std::printf("\n  ]\n}\n");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,475 @@
+#ifndef SHARDED_ADS_SET_H
+#define SHARDED_ADS_SET_H
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+
+#include "ADS_set.h"
+#include "ADS_thread_pool.h"
+
+/**
+ * Set that spreads its keys over independent ADS_set shards, each guarded by its own lock,
+ * so writers of different shards don't contend.
+ *
+ * Keys are routed by the high bits of their mixed hash, while the shards' linear hashing
+ * uses the low bits of the plain hash, so routing doesn't thin out the buckets of a shard.
+ * Bulk operations run on the shards in parallel on a thread pool.
+ *
+ * @tparam Key key type
+ * @tparam N size of the shards' buckets (b in lectures)
+ * @tparam Hash hash function object
+ * @tparam KeyEqual equality function object
+ * @tparam Traits compile-time options of the shards, see ADS_set_traits
+ * @tparam Shards amount of shards, a power of two of at most 256
+ */
+template<typename Key, size_t N = ADS_set_default_bucket_size<Key>::value, typename Hash = std::hash<Key>,
+        typename KeyEqual = std::equal_to<Key>, typename Traits = ADS_set_traits<Key>, size_t Shards = 16>
+class sharded_ADS_set {
+public:
+    class Iterator;
+
+    using value_type = Key;
+    using key_type = Key;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_iterator = Iterator;
+    using iterator = const_iterator;
+    using key_equal = KeyEqual;
+    using hasher = Hash;
+    using shard_type = ADS_set<Key, N, Hash, KeyEqual, Traits>;
+private:
+    static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "Shards has to be a power of two");
+    static_assert(Shards <= 256, "Shards has to fit into a byte");
+
+    /** Size of a cache line, shards are kept apart by it */
+    static constexpr size_type cache_line_size {64};
+
+    /** Amount of keys of a range insert routed by one task */
+    static constexpr size_type route_chunk_size {4096};
+
+    /** Multiplier of Fibonacci hashing, spreads all bits of a hash into its high bits */
+    static constexpr size_type route_multiplier {0x9E3779B97F4A7C15};
+
+    /** Amount of high bits selecting the shard */
+    static constexpr size_type route_bits {__builtin_ctzll(Shards)};
+
+    /**
+     * Shard with its lock, aligned so the locks of different shards don't share a cache line.
+     */
+    struct alignas(cache_line_size) Shard {
+        /** Guards the set */
+        mutable std::mutex mutex;
+
+        /** Values of the shard */
+        shard_type set;
+    };
+
+    /** Shards of the set */
+    Shard shards[Shards];
+
+    /** Pool running the bulk operations */
+    ADS_thread_pool& pool;
+
+    /** Hash instance */
+    const hasher hash {};
+
+    /**
+     * Get the shard of a key's hash. The hash is mixed first, since hashes like the identity
+     * hash of integers leave the high bits empty.
+     *
+     * @param key_hash hash of the key
+     * @return index of the shard
+     */
+    static size_type shard_of(size_type key_hash) {
+        if constexpr (Shards == 1) {
+            return 0;
+        } else {
+            return (key_hash * route_multiplier) >> (sizeof(size_type) * CHAR_BIT - route_bits);
+        }
+    }
+
+    /**
+     * Get the shard a key belongs to.
+     *
+     * @param key the key
+     * @return index of the shard
+     */
+    size_type shard_of_key(const key_type& key) const { return shard_of(hash(key)); }
+
+public:
+    /**
+     * Creates an empty set running bulk operations on the given pool.
+     *
+     * @param pool the thread pool, the shared pool by default
+     */
+    explicit sharded_ADS_set(ADS_thread_pool& pool = ADS_thread_pool::shared()) : pool {pool} {}
+
+    /**
+     * Creates a set with a given range of items.
+     *
+     * @tparam InputIt type of input iterator
+     * @param first first item in range
+     * @param last last item in range
+     * @param pool the thread pool, the shared pool by default
+     */
+    template<typename InputIt>
+    sharded_ADS_set(InputIt first, InputIt last, ADS_thread_pool& pool = ADS_thread_pool::shared());
+
+    /**
+     * Creates a set with a given list of keys.
+     *
+     * @param ilist list of keys to initialize with
+     */
+    sharded_ADS_set(std::initializer_list<key_type> ilist);
+
+    /**
+     * Sets are shared by reference, they can't be copied.
+     */
+    sharded_ADS_set(const sharded_ADS_set&) = delete;
+
+    sharded_ADS_set& operator=(const sharded_ADS_set&) = delete;
+
+    /**
+     * Insert a given key.
+     *
+     * @param key the key to insert
+     * @return whether it was newly added
+     */
+    bool insert(const key_type& key);
+
+    /**
+     * Insert a given key by moving it, which only happens if it doesn't exist yet.
+     *
+     * @param key the key to insert
+     * @return whether it was newly added
+     */
+    bool insert(key_type&& key);
+
+    /**
+     * Insert a range of given keys. Forward ranges are routed to their shards in parallel, sorted
+     * by shard once and every shard inserts its own keys in parallel to the others, input ranges
+     * are inserted one by one.
+     *
+     * @tparam InputIt type of input iterator
+     * @param first first item in range
+     * @param last last item in range
+     */
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last);
+
+    /**
+     * Insert a given list of keys.
+     *
+     * @param ilist list of keys to insert
+     */
+    void insert(std::initializer_list<key_type> ilist) { insert(ilist.begin(), ilist.end()); }
+
+    /**
+     * Removes the given key.
+     *
+     * @param key the key to remove
+     * @return the amount of removed elements
+     */
+    size_type erase(const key_type& key);
+
+    /**
+     * Count how many times a key exists in the set (0 or 1).
+     *
+     * @param key the key to count for
+     * @return how many times the key exists (0 or 1)
+     */
+    size_type count(const key_type& key) const;
+
+    /**
+     * Check whether a key exists in the set.
+     *
+     * @param key the key to check
+     * @return whether the key exists
+     */
+    bool contains(const key_type& key) const { return count(key) != 0; }
+
+    /**
+     * Clear all values of the set, the shards are cleared in parallel.
+     */
+    void clear();
+
+    /**
+     * Get the total amount of stored values. The shards' sizes are summed one by one,
+     * which is cheaper than handing them to the pool.
+     *
+     * @return total amount of stored values
+     */
+    [[nodiscard]] size_type size() const;
+
+    /**
+     * Get whether the set is empty.
+     *
+     * @return if set is empty
+     */
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    /**
+     * Get the iterator to the first item. Iterators walk the shards one after another and
+     * may only be used while no other thread modifies the set.
+     *
+     * @return iterator to first item
+     */
+    const_iterator begin() const;
+
+    /**
+     * Get the Iterator after the last item.
+     *
+     * @return Iterator after the last item
+     */
+    const_iterator end() const;
+};
+
+/**
+ * Forward iterator concatenating the shards of a sharded_ADS_set.
+ */
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+class sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::Iterator {
+public:
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using reference = const value_type&;
+    using pointer = const value_type*;
+    using iterator_category = std::forward_iterator_tag;
+private:
+    /** Shards of the set */
+    const Shard* shards {nullptr};
+
+    /** Index of the current shard */
+    size_type shard_index {0};
+
+    /** Position in the current shard */
+    typename shard_type::const_iterator position {};
+
+    /**
+     * Move on to the first value of the next non-empty shard if the current shard has no more values.
+     * The last shard's end is the end of the set.
+     */
+    void skip_exhausted() {
+        while (shard_index + 1 < Shards && position == shards[shard_index].set.end()) {
+            position = shards[++shard_index].set.begin();
+        }
+    }
+
+public:
+    /**
+     * Creates an iterator that doesn't point to any set.
+     */
+    Iterator() = default;
+
+    /**
+     * Creates an iterator at the given position.
+     *
+     * @param shards shards of the set
+     * @param shard_index index of the shard
+     * @param position position in the shard
+     */
+    Iterator(const Shard* shards, size_type shard_index, typename shard_type::const_iterator position)
+            : shards {shards}, shard_index {shard_index}, position {position} {
+        skip_exhausted();
+    }
+
+    reference operator*() const { return *position; }
+
+    pointer operator->() const { return &*position; }
+
+    Iterator& operator++() {
+        ++position;
+        skip_exhausted();
+
+        return *this;
+    }
+
+    Iterator operator++(int) {
+        Iterator old {*this};
+        ++*this;
+
+        return old;
+    }
+
+    friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+        return lhs.shard_index == rhs.shard_index && lhs.position == rhs.position;
+    }
+
+    friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+        return !(lhs == rhs);
+    }
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+template<typename InputIt>
+sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::sharded_ADS_set(InputIt first, InputIt last,
+                                                                        ADS_thread_pool& pool)
+        : sharded_ADS_set {pool} {
+    insert(first, last);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::sharded_ADS_set(std::initializer_list<key_type> ilist)
+        : sharded_ADS_set {} {
+    insert(ilist);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+bool sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::insert(const key_type& key) {
+    Shard& target {shards[shard_of_key(key)]};
+    std::lock_guard<std::mutex> lock {target.mutex};
+
+    return target.set.insert(key).second;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+bool sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::insert(key_type&& key) {
+    Shard& target {shards[shard_of_key(key)]};
+    std::lock_guard<std::mutex> lock {target.mutex};
+
+    return target.set.insert(std::move(key)).second;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+template<typename InputIt>
+void sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::insert(InputIt first, InputIt last) {
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+            typename std::iterator_traits<InputIt>::iterator_category>) {
+        const auto count {static_cast<size_type>(std::distance(first, last))};
+
+        if (count == 0) return;
+
+        // Route every key once, then sort the keys' positions by shard, so every shard only touches its own keys
+        auto* routes {new unsigned char[count]};
+        InputIt* positions {nullptr};
+
+        try {
+            if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                    typename std::iterator_traits<InputIt>::iterator_category>) {
+                const size_type chunks {(count + route_chunk_size - 1) / route_chunk_size};
+
+                pool.parallel_for(chunks, [&](size_type chunk) {
+                    const size_type begin {chunk * route_chunk_size};
+                    const size_type end {std::min(begin + route_chunk_size, count)};
+
+                    for (size_type i {begin}; i < end; ++i) {
+                        routes[i] = static_cast<unsigned char>(shard_of(hash(first[static_cast<difference_type>(i)])));
+                    }
+                });
+            } else {
+                // Chunks of other ranges can't be reached without walking them
+                auto it {first};
+
+                for (size_type i {0}; i < count; ++i, ++it) {
+                    routes[i] = static_cast<unsigned char>(shard_of(hash(*it)));
+                }
+            }
+
+            // Counting sort: the keys of shard s take the positions from starts[s] to starts[s + 1]
+            size_type starts[Shards + 1] {};
+
+            for (size_type i {0}; i < count; ++i) {
+                ++starts[routes[i] + 1];
+            }
+
+            for (size_type index {0}; index < Shards; ++index) {
+                starts[index + 1] += starts[index];
+            }
+
+            positions = new InputIt[count];
+            size_type next[Shards];
+            std::copy(starts, starts + Shards, next);
+
+            auto it {first};
+
+            for (size_type i {0}; i < count; ++i, ++it) {
+                positions[next[routes[i]]++] = it;
+            }
+
+            pool.parallel_for(Shards, [&](size_type index) {
+                const size_type shard_count {starts[index + 1] - starts[index]};
+
+                if (shard_count == 0) return;
+
+                Shard& target {shards[index]};
+                std::lock_guard<std::mutex> lock {target.mutex};
+
+                target.set.reserve(target.set.size() + shard_count);
+
+                for (size_type k {starts[index]}; k < starts[index + 1]; ++k) {
+                    target.set.insert(*positions[k]);
+                }
+            });
+        } catch (...) {
+            delete[] positions;
+            delete[] routes;
+            throw;
+        }
+
+        delete[] positions;
+        delete[] routes;
+    } else {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+typename sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::size_type
+sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::erase(const key_type& key) {
+    Shard& target {shards[shard_of_key(key)]};
+    std::lock_guard<std::mutex> lock {target.mutex};
+
+    return target.set.erase(key);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+typename sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::size_type
+sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::count(const key_type& key) const {
+    const Shard& target {shards[shard_of_key(key)]};
+    std::lock_guard<std::mutex> lock {target.mutex};
+
+    return target.set.count(key);
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+void sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::clear() {
+    pool.parallel_for(Shards, [&](size_type index) {
+        std::lock_guard<std::mutex> lock {shards[index].mutex};
+        shards[index].set.clear();
+    });
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+typename sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::size_type
+sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::size() const {
+    size_type total {0};
+
+    for (const Shard& current: shards) {
+        std::lock_guard<std::mutex> lock {current.mutex};
+        total += current.set.size();
+    }
+
+    return total;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+typename sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::const_iterator
+sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::begin() const {
+    return const_iterator {shards, 0, shards[0].set.begin()};
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t Shards>
+typename sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::const_iterator
+sharded_ADS_set<Key, N, Hash, KeyEqual, Traits, Shards>::end() const {
+    return const_iterator {shards, Shards - 1, shards[Shards - 1].set.end()};
+}
+
+#endif // SHARDED_ADS_SET_H
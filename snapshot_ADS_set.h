@@ -0,0 +1,533 @@
+#ifndef SNAPSHOT_ADS_SET_H
+#define SNAPSHOT_ADS_SET_H
+
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "ADS_set.h"
+
+/**
+ * Set whose snapshots are taken in O(1) and stay unchanged while the set keeps being modified.
+ *
+ * The keys are spread over ADS_set parts of about PartSize values by a second linear hashing
+ * on the high bits of their mixed hash. A snapshot shares the directory of the parts and the
+ * parts themselves with the set, reference counted. The set clones the directory on its first
+ * modification after a snapshot and a part on its first modification, so a write after a
+ * snapshot costs O(PartSize) once per part instead of O(n) for a copy of the whole set.
+ *
+ * The set itself is used like an ADS_set: its modifications and snapshot() need external
+ * synchronization. Snapshots can be read, copied and destroyed by any thread, also while the
+ * set is being modified.
+ *
+ * @tparam Key key type
+ * @tparam N size of the parts' buckets (b in lectures)
+ * @tparam Hash hash function object
+ * @tparam KeyEqual equality function object
+ * @tparam Traits compile-time options of the parts, see ADS_set_traits
+ * @tparam PartSize amount of values per part before the parts split
+ */
+template<typename Key, size_t N = ADS_set_default_bucket_size<Key>::value, typename Hash = std::hash<Key>,
+        typename KeyEqual = std::equal_to<Key>, typename Traits = ADS_set_traits<Key>, size_t PartSize = 4096>
+class snapshot_ADS_set {
+public:
+    class Iterator;
+    class Snapshot;
+
+    using value_type = Key;
+    using key_type = Key;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_iterator = Iterator;
+    using iterator = const_iterator;
+    using key_equal = KeyEqual;
+    using hasher = Hash;
+    using part_type = ADS_set<Key, N, Hash, KeyEqual, Traits>;
+private:
+    static_assert(PartSize > 0, "PartSize has to be positive");
+
+    /** Multiplier of Fibonacci hashing, spreads all bits of a hash into its high bits */
+    static constexpr size_type route_multiplier {0x9E3779B97F4A7C15};
+
+    /**
+     * Parts of a set with the state of the linear hashing selecting them. Snapshots share it
+     * with the set until the set is modified.
+     */
+    struct Directory {
+        /** Current round of splitting, there are 2^split_round + split_index parts */
+        size_type split_round {0};
+
+        /** Index of the part to split next */
+        size_type split_index {0};
+
+        /** Total amount of stored values */
+        size_type items_size {0};
+
+        /** Parts of the set, shared with snapshots until they are modified */
+        std::vector<std::shared_ptr<part_type>> parts;
+
+        /**
+         * Creates a directory with a single empty part.
+         */
+        Directory() : parts {std::make_shared<part_type>()} {}
+
+        /**
+         * Get the part of a key's hash. The parts' linear hashing uses the low bits of the
+         * plain hash, so the parts take the high bits of the mixed hash instead, which don't
+         * thin out the buckets of a part.
+         *
+         * @param key_hash hash of the key
+         * @return index of the part
+         */
+        size_type part_of(size_type key_hash) const;
+    };
+
+    /** Directory of the set, shared with snapshots until the set is modified */
+    std::shared_ptr<Directory> directory {std::make_shared<Directory>()};
+
+    /** Hash instance */
+    const hasher hash {};
+
+    /**
+     * Get whether the set is the only owner of a pointer. Snapshots release their references
+     * with acquire-release decrements, so the fence after a count of one orders their last
+     * reads before the following writes of the set.
+     *
+     * @tparam T type of the owned object
+     * @param pointer the pointer
+     * @return whether no snapshot shares the object
+     */
+    template<typename T>
+    static bool exclusive(const std::shared_ptr<T>& pointer);
+
+    /**
+     * Get the directory for a modification, cloning it if a snapshot shares it.
+     *
+     * @return the directory owned by the set alone
+     */
+    Directory& writable_directory();
+
+    /**
+     * Get a part for a modification, cloning it if a snapshot shares it.
+     *
+     * @param current the directory owned by the set alone
+     * @param index index of the part
+     * @return the part owned by the set alone
+     */
+    static part_type& writable_part(Directory& current, size_type index);
+
+    /**
+     * Split the next part of the linear hashing. Its values are moved in a clone, so a failed
+     * split leaves the set as it was.
+     *
+     * @param current the directory owned by the set alone
+     */
+    void split(Directory& current);
+
+    /**
+     * Insert a key after the modification of its part.
+     *
+     * @tparam K type of the key
+     * @param key the key to insert
+     * @return whether it was newly added
+     */
+    template<typename K>
+    bool insert_key(K&& key);
+
+public:
+    /**
+     * Creates an empty set.
+     */
+    snapshot_ADS_set() = default;
+
+    /**
+     * Creates a set with a given range of items.
+     *
+     * @tparam InputIt type of input iterator
+     * @param first first item in range
+     * @param last last item in range
+     */
+    template<typename InputIt>
+    snapshot_ADS_set(InputIt first, InputIt last) { insert(first, last); }
+
+    /**
+     * Creates a set with a given list of keys.
+     *
+     * @param ilist list of keys to initialize with
+     */
+    snapshot_ADS_set(std::initializer_list<key_type> ilist) { insert(ilist); }
+
+    /**
+     * Copies a set in O(1), the copies share the directory and the parts until they modify them.
+     *
+     * @param other the set to copy
+     */
+    snapshot_ADS_set(const snapshot_ADS_set& other) : directory {other.directory} {}
+
+    snapshot_ADS_set& operator=(const snapshot_ADS_set& other) {
+        directory = other.directory;
+
+        return *this;
+    }
+
+    /**
+     * Get a read-only view of the current values in O(1). Later modifications of the set don't
+     * change it.
+     *
+     * @return the snapshot
+     */
+    Snapshot snapshot() const { return Snapshot {directory}; }
+
+    /**
+     * Insert a given key.
+     *
+     * @param key the key to insert
+     * @return whether it was newly added
+     */
+    bool insert(const key_type& key) { return insert_key(key); }
+
+    /**
+     * Insert a given key by moving it, which only happens if it doesn't exist yet.
+     *
+     * @param key the key to insert
+     * @return whether it was newly added
+     */
+    bool insert(key_type&& key) { return insert_key(std::move(key)); }
+
+    /**
+     * Insert a range of given keys.
+     *
+     * @tparam InputIt type of input iterator
+     * @param first first item in range
+     * @param last last item in range
+     */
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last);
+
+    /**
+     * Insert a given list of keys.
+     *
+     * @param ilist list of keys to insert
+     */
+    void insert(std::initializer_list<key_type> ilist) { insert(ilist.begin(), ilist.end()); }
+
+    /**
+     * Removes the given key. Parts are not merged again, they are only cloned if they hold the key.
+     *
+     * @param key the key to remove
+     * @return the amount of removed elements
+     */
+    size_type erase(const key_type& key);
+
+    /**
+     * Count how many times a key exists in the set (0 or 1).
+     *
+     * @param key the key to count for
+     * @return how many times the key exists (0 or 1)
+     */
+    size_type count(const key_type& key) const { return directory->parts[directory->part_of(hash(key))]->count(key); }
+
+    /**
+     * Check whether a key exists in the set.
+     *
+     * @param key the key to check
+     * @return whether the key exists
+     */
+    bool contains(const key_type& key) const { return count(key) != 0; }
+
+    /**
+     * Clear all values of the set. Snapshots keep theirs.
+     */
+    void clear() { directory = std::make_shared<Directory>(); }
+
+    /**
+     * Get the total amount of stored values.
+     *
+     * @return total amount of stored values
+     */
+    [[nodiscard]] size_type size() const { return directory->items_size; }
+
+    /**
+     * Get whether the set is empty.
+     *
+     * @return if set is empty
+     */
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    /**
+     * Get the iterator to the first item. Iterators are invalidated by every modification of
+     * the set, iterators of snapshots aren't.
+     *
+     * @return iterator to first item
+     */
+    const_iterator begin() const { return const_iterator {directory.get(), 0, directory->parts[0]->begin()}; }
+
+    /**
+     * Get the Iterator after the last item.
+     *
+     * @return Iterator after the last item
+     */
+    const_iterator end() const {
+        return const_iterator {directory.get(), directory->parts.size() - 1, directory->parts.back()->end()};
+    }
+};
+
+/**
+ * Read-only view of a snapshot_ADS_set at the time it was taken. Copies share the view.
+ */
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+class snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::Snapshot {
+    friend class snapshot_ADS_set;
+
+    /** Directory at the time of the snapshot */
+    std::shared_ptr<const Directory> directory;
+
+    /** Hash instance */
+    hasher hash {};
+
+    /**
+     * Creates a snapshot of the given directory.
+     *
+     * @param directory the directory
+     */
+    explicit Snapshot(std::shared_ptr<const Directory> directory) : directory {std::move(directory)} {}
+
+public:
+    /**
+     * Count how many times a key existed in the set (0 or 1).
+     *
+     * @param key the key to count for
+     * @return how many times the key exists (0 or 1)
+     */
+    size_type count(const key_type& key) const { return directory->parts[directory->part_of(hash(key))]->count(key); }
+
+    /**
+     * Check whether a key existed in the set.
+     *
+     * @param key the key to check
+     * @return whether the key exists
+     */
+    bool contains(const key_type& key) const { return count(key) != 0; }
+
+    /**
+     * Get the amount of values at the time of the snapshot.
+     *
+     * @return amount of values
+     */
+    [[nodiscard]] size_type size() const { return directory->items_size; }
+
+    /**
+     * Get whether the set was empty.
+     *
+     * @return if set is empty
+     */
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    /**
+     * Get the iterator to the first item, valid as long as the snapshot or a copy of it exists.
+     *
+     * @return iterator to first item
+     */
+    const_iterator begin() const { return const_iterator {directory.get(), 0, directory->parts[0]->begin()}; }
+
+    /**
+     * Get the Iterator after the last item.
+     *
+     * @return Iterator after the last item
+     */
+    const_iterator end() const {
+        return const_iterator {directory.get(), directory->parts.size() - 1, directory->parts.back()->end()};
+    }
+};
+
+/**
+ * Forward iterator concatenating the parts of a snapshot_ADS_set or of a snapshot.
+ */
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+class snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::Iterator {
+public:
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using reference = const value_type&;
+    using pointer = const value_type*;
+    using iterator_category = std::forward_iterator_tag;
+private:
+    /** Directory of the parts */
+    const Directory* directory {nullptr};
+
+    /** Index of the current part */
+    size_type part_index {0};
+
+    /** Position in the current part */
+    typename part_type::const_iterator position {};
+
+    /**
+     * Move on to the first value of the next non-empty part if the current part has no more values.
+     * The last part's end is the end of the set.
+     */
+    void skip_exhausted() {
+        while (part_index + 1 < directory->parts.size() && position == directory->parts[part_index]->end()) {
+            position = directory->parts[++part_index]->begin();
+        }
+    }
+
+public:
+    /**
+     * Creates an iterator that doesn't point to any set.
+     */
+    Iterator() = default;
+
+    /**
+     * Creates an iterator at the given position.
+     *
+     * @param directory directory of the parts
+     * @param part_index index of the part
+     * @param position position in the part
+     */
+    Iterator(const Directory* directory, size_type part_index, typename part_type::const_iterator position)
+            : directory {directory}, part_index {part_index}, position {position} {
+        skip_exhausted();
+    }
+
+    reference operator*() const { return *position; }
+
+    pointer operator->() const { return &*position; }
+
+    Iterator& operator++() {
+        ++position;
+        skip_exhausted();
+
+        return *this;
+    }
+
+    Iterator operator++(int) {
+        Iterator old {*this};
+        ++*this;
+
+        return old;
+    }
+
+    friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+        return lhs.part_index == rhs.part_index && lhs.position == rhs.position;
+    }
+
+    friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+        return !(lhs == rhs);
+    }
+};
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+typename snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::size_type
+snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::Directory::part_of(size_type key_hash) const {
+    const size_type route {(key_hash * route_multiplier) >> (sizeof(size_type) * CHAR_BIT / 2)};
+    const size_type index {route & ((size_type {1} << split_round) - 1)};
+
+    if (index < split_index) return route & ((size_type {2} << split_round) - 1);
+
+    return index;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+template<typename T>
+bool snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::exclusive(const std::shared_ptr<T>& pointer) {
+    if (pointer.use_count() != 1) return false;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return true;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+typename snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::Directory&
+snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::writable_directory() {
+    if (!exclusive(directory)) directory = std::make_shared<Directory>(*directory);
+
+    return *directory;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+typename snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::part_type&
+snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::writable_part(Directory& current, size_type index) {
+    std::shared_ptr<part_type>& part {current.parts[index]};
+
+    if (!exclusive(part)) part = std::make_shared<part_type>(*part);
+
+    return *part;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+void snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::split(Directory& current) {
+    const size_type index {current.split_index};
+    const size_type partner_index {index + (size_type {1} << current.split_round)};
+    const size_type mask {(size_type {2} << current.split_round) - 1};
+
+    auto kept {std::make_shared<part_type>(*current.parts[index])};
+    auto moved {std::make_shared<part_type>()};
+
+    kept->erase_if([&](const key_type& key) {
+        const size_type route {(hash(key) * route_multiplier) >> (sizeof(size_type) * CHAR_BIT / 2)};
+
+        if ((route & mask) != partner_index) return false;
+
+        moved->insert(key);
+
+        return true;
+    });
+
+    current.parts.push_back(std::move(moved));
+    current.parts[index] = std::move(kept);
+
+    if (++current.split_index == size_type {1} << current.split_round) {
+        current.split_index = 0;
+        ++current.split_round;
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+template<typename K>
+bool snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::insert_key(K&& key) {
+    const size_type index {directory->part_of(hash(key))};
+
+    // A shared part is only cloned for a key it doesn't hold yet
+    if (!exclusive(directory) || !exclusive(directory->parts[index])) {
+        if (directory->parts[index]->count(key) != 0) return false;
+    }
+
+    Directory& current {writable_directory()};
+
+    if (!writable_part(current, index).insert(std::forward<K>(key)).second) return false;
+
+    if (++current.items_size > current.parts.size() * PartSize) split(current);
+
+    return true;
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+template<typename InputIt>
+void snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+        insert(*first);
+    }
+}
+
+template<typename Key, size_t N, typename Hash, typename KeyEqual, typename Traits, size_t PartSize>
+typename snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::size_type
+snapshot_ADS_set<Key, N, Hash, KeyEqual, Traits, PartSize>::erase(const key_type& key) {
+    const size_type index {directory->part_of(hash(key))};
+
+    if (directory->parts[index]->count(key) == 0) return 0;
+
+    Directory& current {writable_directory()};
+
+    writable_part(current, index).erase(key);
+    --current.items_size;
+
+    return 1;
+}
+
+#endif // SNAPSHOT_ADS_SET_H